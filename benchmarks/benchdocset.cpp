@@ -0,0 +1,293 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include <registry/cancellationtoken.h>
+#include <registry/docset.h>
+#include <registry/searchscore.h>
+#include <zealtokentable.h>
+
+#include <docsetgenerator.h>
+
+#include <QDir>
+#include <QHash>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <memory>
+
+using Zeal::Registry::CancellationToken;
+using Zeal::Registry::Docset;
+
+/*!
+ * \brief Benchmarks of the paths users wait on: scoring, searching, opening docsets
+ * and building the provider's token table.
+ *
+ * Every run works on the same generated docset (ZEAL_BENCH_SYMBOLS symbols, 50000 by
+ * default, seed ZEAL_BENCH_SEED), so numbers from different runs can be compared.
+ */
+class BenchDocset : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+
+	void benchScore_data();
+	void benchScore();
+	void benchSearch_data();
+	void benchSearch();
+	void benchOpenCold();
+	void benchOpenWarm();
+	void benchLoadSymbols();
+	void benchTokenTable();
+	void benchTokenTableMemory();
+
+private:
+	void addQueries();
+	int  scoreAll( const QString& query ) const;
+	ZealTokenTable buildTokenTable() const;
+
+	QTemporaryDir		m_dir;
+	QString			m_fixture;
+	QStringList		m_names;
+	QHash<QString, int>	m_matches; /*!< Names each query matches, counted once up front. */
+	std::unique_ptr<Docset> m_docset;
+};
+
+namespace {
+int environment( const char* name, int defaultValue )
+{
+	bool	  ok{ false };
+	const int value{ qEnvironmentVariableIntValue( name, &ok ) };
+	return ok && value > 0 ? value : defaultValue;
+}
+
+bool copyTree( const QString& from, const QString& to )
+{
+	QDir source{ from };
+
+	if ( !QDir{}.mkpath( to ) ) { return false; }
+
+	for ( const QFileInfo& info : source.entryInfoList( QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden ) )
+	{
+		const QString target{ QDir( to ).filePath( info.fileName() ) };
+
+		if ( info.isDir() ? !copyTree( info.filePath(), target ) : !QFile::copy( info.filePath(), target ) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+}    // namespace
+
+void BenchDocset::initTestCase()
+{
+	QVERIFY( m_dir.isValid() );
+
+	const int     symbols{ environment( "ZEAL_BENCH_SYMBOLS", 50000 ) };
+	const quint32 seed( environment( "ZEAL_BENCH_SEED", 1 ) );
+
+	DocsetGenerator::Options options;
+	options.name	    = QStringLiteral( "Fixture" );
+	options.symbolCount = symbols;
+	options.seed	    = seed;
+
+	DocsetGenerator generator{ options };
+	m_fixture = generator.generate( m_dir.filePath( QStringLiteral( "fixture" ) ) );
+	QVERIFY2( !m_fixture.isEmpty(), qPrintable( generator.errorString() ) );
+
+	m_names = DocsetGenerator::symbolNames( symbols, seed );
+
+	// Opened once up front so the index exists for everything but benchOpenCold
+	m_docset = std::make_unique<Docset>( m_fixture );
+	QVERIFY( m_docset->isValid() );
+
+	int indexed{ 0 };
+
+	for ( const int count : m_docset->symbolCounts() ) { indexed += count; }
+
+	QCOMPARE( indexed, m_names.size() );
+
+	// What the benchmarks below must find, an empty or broken fixture fails here
+	for ( const QString& query : { QStringLiteral( "v" ), QStringLiteral( "vec" ), QStringLiteral( "vectorpush" ) } )
+	{
+		m_matches[query] = scoreAll( query );
+		QVERIFY2( m_matches[query] > 0, qPrintable( query ) );
+	}
+}
+
+int BenchDocset::scoreAll( const QString& query ) const
+{
+	const QByteArray needle{ query.toUtf8() };
+	int		 matches{ 0 };
+
+	for ( const QString& name : qAsConst( m_names ) )
+	{
+		const QByteArray haystack{ name.toUtf8() };
+
+		if ( Zeal::Registry::SearchScore::score( reinterpret_cast<const unsigned char*>( needle.constData() ),
+							 needle.size(),
+							 reinterpret_cast<const unsigned char*>( haystack.constData() ),
+							 haystack.size() )
+		     > 0 )
+		{
+			++matches;
+		}
+	}
+
+	return matches;
+}
+
+void BenchDocset::addQueries()
+{
+	QTest::addColumn<QString>( "query" );
+
+	QTest::newRow( "1 char" ) << QStringLiteral( "v" );
+	QTest::newRow( "3 chars" ) << QStringLiteral( "vec" );
+	QTest::newRow( "10 chars" ) << QStringLiteral( "vectorpush" );
+}
+
+void BenchDocset::benchScore_data() { addQueries(); }
+
+void BenchDocset::benchScore()
+{
+	QFETCH( QString, query );
+
+	const QByteArray	needle{ query.toUtf8() };
+	QVector<QByteArray> haystacks;
+	haystacks.reserve( m_names.size() );
+
+	for ( const QString& name : qAsConst( m_names ) ) { haystacks << name.toUtf8(); }
+
+	int matches{ 0 };
+
+	QBENCHMARK
+	{
+		matches = 0;
+
+		for ( const QByteArray& haystack : qAsConst( haystacks ) )
+		{
+			if ( Zeal::Registry::SearchScore::score( reinterpret_cast<const unsigned char*>( needle.constData() ),
+								 needle.size(),
+								 reinterpret_cast<const unsigned char*>( haystack.constData() ),
+								 haystack.size() )
+			     > 0 )
+			{
+				++matches;
+			}
+		}
+	}
+
+	QCOMPARE( matches, m_matches.value( query ) );
+}
+
+void BenchDocset::benchSearch_data() { addQueries(); }
+
+void BenchDocset::benchSearch()
+{
+	QFETCH( QString, query );
+
+	const CancellationToken token;
+	int			results{ 0 };
+
+	QBENCHMARK { results = m_docset->search( query, token ).size(); }
+
+	// Docset::search() caps queries shorter than three characters at 1000 rows
+	const int expected{ m_matches.value( query ) };
+	QCOMPARE( results, query.size() < 3 ? qMin( expected, 1000 ) : expected );
+}
+
+void BenchDocset::benchOpenCold()
+{
+	// A fresh copy has no index yet, so this includes createIndex()
+	const QString copy{ m_dir.filePath( QStringLiteral( "cold/Fixture.docset" ) ) };
+	QVERIFY( copyTree( m_fixture, copy ) );
+
+	QBENCHMARK_ONCE
+	{
+		const Docset docset{ copy };
+		QVERIFY( docset.isValid() );
+	}
+}
+
+void BenchDocset::benchOpenWarm()
+{
+	QBENCHMARK
+	{
+		const Docset docset{ m_fixture };
+		QVERIFY( docset.isValid() );
+	}
+}
+
+void BenchDocset::benchLoadSymbols()
+{
+	const QStringList types{ m_docset->symbolCounts().keys() };
+	int		  count{ 0 };
+
+	QBENCHMARK
+	{
+		count = 0;
+
+		for ( const QString& type : types )
+		{
+			m_docset->forEachSymbol( type, [&count]( const QString&, const Docset::PageLocation& ) { ++count; } );
+		}
+	}
+
+	QCOMPARE( count, m_names.size() );
+}
+
+ZealTokenTable BenchDocset::buildTokenTable() const
+{
+	ZealTokenTable::Builder builder{ m_docset->documentPath() };
+	const QStringList	types{ m_docset->symbolCounts().keys() };
+
+	for ( const QString& type : types )
+	{
+		m_docset->forEachSymbol( type,
+					 [&builder, &type]( const QString& name, const Docset::PageLocation& location )
+					 { builder.add( type, name, location ); } );
+	}
+
+	return builder.build();
+}
+
+void BenchDocset::benchTokenTable()
+{
+	int size{ 0 };
+
+	QBENCHMARK { size = buildTokenTable().size(); }
+
+	QVERIFY( size > 0 );
+}
+
+void BenchDocset::benchTokenTableMemory()
+{
+	// What one docset costs the provider once loaded, reported like any other result
+	const ZealTokenTable table{ buildTokenTable() };
+	QTest::setBenchmarkResult( table.memoryUsage(), QTest::BytesAllocated );
+}
+
+QTEST_GUILESS_MAIN( BenchDocset )
+
+#include "benchdocset.moc"
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Compares QtTest CSV benchmark results against a stored baseline.
+
+QtTest writes one line per benchmark: function, data tag, metric, value per
+iteration, total and iterations. Results are matched by function and tag; a
+result that is more than --tolerance percent above its baseline fails the run.
+Benchmarks without a baseline are reported but never fail.
+"""
+
+import argparse
+import csv
+import shutil
+import sys
+
+
+def read_results(path):
+    results = {}
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if len(row) < 4:
+                continue
+            try:
+                value = float(row[3])
+            except ValueError:
+                continue  # a header or a truncated line
+            results[(row[0], row[1])] = (row[2], value)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="CSV file with the reference results")
+    parser.add_argument("results", help="CSV file written by the benchmark run")
+    parser.add_argument("--tolerance", type=float, default=15.0,
+                        help="allowed slowdown in percent (default: 15)")
+    parser.add_argument("--update", action="store_true",
+                        help="replace the baseline with the results")
+    args = parser.parse_args()
+
+    if args.update:
+        shutil.copyfile(args.results, args.baseline)
+        print("Baseline updated: %s" % args.baseline)
+        return 0
+
+    current = read_results(args.results)
+    try:
+        baseline = read_results(args.baseline)
+    except FileNotFoundError:
+        print("No baseline at %s, run the benchmark-baseline target to record one"
+              % args.baseline)
+        return 0
+
+    failed = 0
+    for key in sorted(current):
+        metric, value = current[key]
+        name = "%s(%s)" % key if key[1] else key[0]
+        if key not in baseline:
+            print("  new   %-50s %14.3f %s" % (name, value, metric))
+            continue
+        reference = baseline[key][1]
+        change = (value - reference) / reference * 100.0 if reference else 0.0
+        regressed = change > args.tolerance
+        failed += regressed
+        print("%s %-50s %14.3f %s (%+.1f%%)"
+              % ("  FAIL " if regressed else "  ok   ", name, value, metric, change))
+
+    for key in sorted(set(baseline) - set(current)):
+        print("  gone  %s" % ("%s(%s)" % key if key[1] else key[0]))
+
+    if failed:
+        print("%d benchmark(s) regressed by more than %g%%" % (failed, args.tolerance))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -22,11 +22,15 @@
 #include <interfaces/icore.h>
 #include <interfaces/idocumentationcontroller.h>
 
+#include <registry/documentarchive.h>
+#include <util/trace.h>
+
 #include <KLocalizedString>
 #include <KPluginFactory>
 
 #include "debug.h"
 #include "util.h"
+#include "zealdeclarationcache.h"
 #include "zealdocconfigpage.h"
 #include "zealdocprovider.h"
 
@@ -35,7 +39,13 @@ K_PLUGIN_FACTORY_WITH_JSON( ZealdocFactory, "kdevzealdoc.json", registerPlugin<Z
 
 ZealdocPlugin::ZealdocPlugin( QObject* parent, const QVariantList& )
 	: KDevelop::IPlugin( QString::fromLocal8Bit( "kdevzealdoc" ), parent )
+	, m_declarationCache{ new ZealDeclarationCache{ this } }
+	, m_memoryBudget{ providerMemoryBudget() }
+	, m_traceFile{ QString::fromLocal8Bit( qgetenv( "KDEVZEALDOC_TRACE" ) ) }
 {
+	// Opt-in profiling: KDEVZEALDOC_TRACE=/tmp/zeal.json records the session as a Chrome trace
+	if ( !m_traceFile.isEmpty() ) { Zeal::Util::Trace::start(); }
+
 	// Connect the signal changedProvidersList to the documentationController's slot
 	connect( this,
 		 &ZealdocPlugin::changedProvidersList,
@@ -47,60 +57,113 @@ ZealdocPlugin::ZealdocPlugin( QObject* parent, const QVariantList& )
 }
 
 // Destructor
-ZealdocPlugin::~ZealdocPlugin() = default;
+ZealdocPlugin::~ZealdocPlugin()
+{
+	if ( !m_traceFile.isEmpty() ) { Zeal::Util::Trace::stop( m_traceFile ); }
+}
 
 // Reloads documentation sets based on enabled docsets
 void ZealdocPlugin::reloadDocsets()
 {
+	// Providers are rebuilt and KDevelop's views reset on the GUI thread, the user waits for it
+	ZEAL_TRACE_SPAN( "gui", "ZealdocPlugin::reloadDocsets" );
+
+	m_memoryBudget.setBudget( providerMemoryBudget() );
+	Zeal::Registry::DocumentArchive::setCacheSize( documentArchiveCacheSize() );
+	m_declarationCache->setLanguageKeywords( languageKeywords() );
+
 	const QStringList enabled{ enabledDocsets() };	  // Retrieve enabled documentation sets
-	QStringList loaded;		   // List of currently loaded docsets
-	bool	    hasChanges = false;	   // Flag to track changes in providers list
+	const bool	  aggregate{ aggregateDocsets() };    // One provider for all docsets?
+	QStringList	  loaded;		   // List of currently loaded docsets
+	bool		  hasChanges = false;	   // Flag to track changes in providers list
+
+	const auto unloadProvider = [this]( ZealdocProvider* provider ) {
+		m_memoryBudget.remove( provider );
+		provider->deleteLater();
+	};
+
+	const auto addProvider = [this]( ZealdocProvider* provider ) {
+		if ( !provider->isValid() )
+		{
+			delete provider;    // Clean up invalid docset objects
+			return false;
+		}
 
-	// First, unload disabled docsets
-	QMutableListIterator<ZealdocProvider*> i( m_providers );
+		m_providers << provider;    // Add valid docset provider to list
+		m_memoryBudget.add( provider );
+		return true;
+	};
 
-	while ( i.hasNext() )
+	if ( aggregate )
 	{
-		ZealdocProvider* provider{ i.next() };
+		QStringList paths;
 
-		if ( !enabled.contains( provider->name() ) )
+		for ( const auto& docsetInformation : availableDocsets() )
 		{
-			i.remove();	      // Remove provider from list
-			hasChanges = true;    // Indicate changes were made
+			if ( enabled.contains( docsetInformation.title ) ) { paths << docsetInformation.path; }
 		}
-		else
+
+		// Rebuild the merged provider whenever the set of docsets or their ranking changes
+		if ( m_providers.size() != 1 || m_providers.first()->docsetPaths() != paths
+		     || m_providers.first()->priorities() != docsetPriorities() )
 		{
-			loaded << provider->name();    // Store name of loaded provider
+			for ( auto* provider : qAsConst( m_providers ) ) { unloadProvider( provider ); }
+
+			m_providers.clear();
+
+			if ( !paths.isEmpty() )
+			{
+				addProvider( new ZealdocProvider( paths, m_declarationCache, &m_memoryBudget, &m_snippetIndex, this ) );
+			}
+
+			hasChanges = true;
 		}
 	}
-
-	// Second, load new enabled docsets
-	for ( const auto& docsetInformation : availableDocsets() )
+	else
 	{
-		if ( !enabled.contains( docsetInformation.title ) )
-		{
-			continue;    // Skip docsets not enabled
-		}
+		// First, unload disabled docsets and a merged provider left from aggregated mode
+		QMutableListIterator<ZealdocProvider*> i( m_providers );
 
-		if ( loaded.contains( docsetInformation.title ) )
+		while ( i.hasNext() )
 		{
-			continue;    // Skip docsets already loaded
+			ZealdocProvider* provider{ i.next() };
+
+			if ( !enabled.contains( provider->name() ) || provider->docsetPaths().size() > 1 )
+			{
+				i.remove();	      // Remove provider from list
+				unloadProvider( provider );
+				hasChanges = true;    // Indicate changes were made
+			}
+			else
+			{
+				loaded << provider->name();    // Store name of loaded provider
+			}
 		}
 
-		auto docset = new ZealdocProvider( docsetInformation.path, this );
-
-		if ( !docset->isValid() )
+		// Second, load new enabled docsets
+		for ( const auto& docsetInformation : availableDocsets() )
 		{
-			delete docset;	  // Clean up invalid docset objects
-			continue;
+			if ( !enabled.contains( docsetInformation.title ) )
+			{
+				continue;    // Skip docsets not enabled
+			}
+
+			if ( loaded.contains( docsetInformation.title ) )
+			{
+				continue;    // Skip docsets already loaded
+			}
+
+			if ( addProvider( new ZealdocProvider(
+				     docsetInformation.path, m_declarationCache, &m_memoryBudget, &m_snippetIndex, this ) ) )
+			{
+				hasChanges = true;    // Indicate changes were made
+			}
 		}
-
-		m_providers << docset;	  // Add valid docset provider to list
-		hasChanges = true;	  // Indicate changes were made
 	}
 
-	if ( !hasChanges )
+	if ( hasChanges )
 	{
+		m_declarationCache->clear();	// Cached rows refer to the old providers
 		emit changedProvidersList();	// Emit signal if providers list was modified
 	}
 }
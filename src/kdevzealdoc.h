@@ -24,6 +24,10 @@
 
 #include <QObject>
 
+#include "zealmemorybudget.h"
+#include "zealsnippetindex.h"
+
+class ZealDeclarationCache;
 class ZealdocProvider;
 
 /*!
@@ -86,4 +90,8 @@ Q_SIGNALS:
 
 private:
 	QList<ZealdocProvider*> m_providers; /*!< List of documentation providers managed by the plugin. */
+	ZealDeclarationCache*	m_declarationCache; /*!< Declarations resolved by the providers. */
+	ZealMemoryBudget	m_memoryBudget;	    /*!< Bounds the memory of all providers' symbol tables. */
+	ZealSnippetIndex	m_snippetIndex;	    /*!< Hover snippets of all providers' pages. */
+	QString			m_traceFile;	    /*!< Where the trace is written on unload, empty if not tracing. */
 };
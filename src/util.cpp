@@ -25,6 +25,7 @@
 #include <KSharedConfig>
 #include <QCoreApplication>
 #include <QDir>
+#include <QFileInfo>
 #include <QStandardPaths>
 #include <QString>
 
@@ -68,27 +69,151 @@ QStringList enabledDocsets()
 	return zealdocConfig().readEntry( QStringLiteral( "EnabledDocsets" ), QStringList{} );
 }
 
+Zeal::Util::SQLiteDatabase::Profile docsetDatabaseProfile()
+{
+	const KConfigGroup config{ zealdocConfig() };
+
+	Zeal::Util::SQLiteDatabase::Profile profile;
+	// Docsets are only read, so map them and keep sorts for search off the disk.
+	// The cache is per docset, not per connection, so it doesn't grow with the cores.
+	// Immutable skips locking entirely and is only safe while Zeal doesn't update
+	// the docsets, so that one stays opt-in.
+	profile.mmapSize = config.readEntry( QStringLiteral( "SQLiteMmapSizeMiB" ), 256 ) * 1024LL * 1024LL;
+	profile.cacheSize = -config.readEntry( QStringLiteral( "SQLiteCacheSizeKiB" ), 16384 );
+	profile.tempStoreMemory = config.readEntry( QStringLiteral( "SQLiteTempStoreMemory" ), true );
+	profile.queryOnly = config.readEntry( QStringLiteral( "SQLiteQueryOnly" ), true );
+	profile.immutable = config.readEntry( QStringLiteral( "SQLiteImmutable" ), false );
+
+	return profile;
+}
+
+qint64 providerMemoryBudget()
+{
+	return zealdocConfig().readEntry( QStringLiteral( "MemoryBudgetMiB" ), 512 ) * 1024LL * 1024LL;
+}
+
+qint64 documentArchiveCacheSize()
+{
+	return zealdocConfig().readEntry( QStringLiteral( "ArchiveCacheMiB" ), 32 ) * 1024LL * 1024LL;
+}
+
+QHash<QString, QStringList> languageKeywords()
+{
+	const KConfigGroup config{ zealdocConfig().group( QStringLiteral( "LanguageKeywords" ) ) };
+
+	QHash<QString, QStringList> keywords;
+
+	for ( const QString& language : config.keyList() )
+	{
+		keywords.insert( language, config.readEntry( language, QStringList{} ) );
+	}
+
+	if ( !keywords.isEmpty() ) { return keywords; }
+
+	const QStringList cpp{ QStringLiteral( "c" ),	 QStringLiteral( "c++" ), QStringLiteral( "cpp" ),
+			       QStringLiteral( "stl" ),	 QStringLiteral( "boost" ), QStringLiteral( "qt" ),
+			       QStringLiteral( "qt5" ), QStringLiteral( "qt6" ), QStringLiteral( "opengl" ) };
+
+	keywords.insert( QStringLiteral( "Clang" ), cpp );
+	keywords.insert( QStringLiteral( "C++" ), cpp );
+	keywords.insert( QStringLiteral( "QML/JS" ),
+			 { QStringLiteral( "qml" ),
+			   QStringLiteral( "qt" ),
+			   QStringLiteral( "qt5" ),
+			   QStringLiteral( "qt6" ),
+			   QStringLiteral( "javascript" ),
+			   QStringLiteral( "js" ) } );
+	keywords.insert( QStringLiteral( "Python" ),
+			 { QStringLiteral( "python" ),
+			   QStringLiteral( "python2" ),
+			   QStringLiteral( "python3" ),
+			   QStringLiteral( "django" ),
+			   QStringLiteral( "flask" ),
+			   QStringLiteral( "numpy" ),
+			   QStringLiteral( "scipy" ),
+			   QStringLiteral( "pandas" ) } );
+	keywords.insert( QStringLiteral( "Php" ),
+			 { QStringLiteral( "php" ), QStringLiteral( "laravel" ), QStringLiteral( "symfony" ) } );
+	keywords.insert( QStringLiteral( "CMake" ), { QStringLiteral( "cmake" ) } );
+	keywords.insert( QStringLiteral( "Go" ), { QStringLiteral( "go" ), QStringLiteral( "godoc" ) } );
+	keywords.insert( QStringLiteral( "Rust" ), { QStringLiteral( "rust" ) } );
+
+	return keywords;
+}
+
+bool aggregateDocsets()
+{
+	return zealdocConfig().readEntry( QStringLiteral( "AggregateDocsets" ), false );
+}
+
+QHash<QString, int> docsetPriorities()
+{
+	const KConfigGroup config{ zealdocConfig().group( QStringLiteral( "DocsetPriorities" ) ) };
+
+	QHash<QString, int> priorities;
+
+	for ( const QString& title : config.keyList() ) { priorities.insert( title, config.readEntry( title, 0 ) ); }
+
+	return priorities;
+}
+
+DocsetStats docsetStats( const QString& title )
+{
+	const KConfigGroup config{ zealdocConfig().group( QStringLiteral( "DocsetStats" ) ).group( title ) };
+
+	return { config.readEntry( QStringLiteral( "LoadTimeMs" ), qint64{ -1 } ),
+		 config.readEntry( QStringLiteral( "MemoryBytes" ), qint64{ -1 } ) };
+}
+
+void storeDocsetStats( const QString& title, const DocsetStats& stats )
+{
+	// KConfig isn't thread-safe, and tables may be built on any thread
+	QMetaObject::invokeMethod( QCoreApplication::instance(), [title, stats] {
+		KConfigGroup config{ KSharedConfig::openConfig(), QStringLiteral( "Zealdoc" ) };
+		KConfigGroup group{ config.group( QStringLiteral( "DocsetStats" ) ).group( title ) };
+
+		group.writeEntry( QStringLiteral( "LoadTimeMs" ), stats.loadTime );
+		group.writeEntry( QStringLiteral( "MemoryBytes" ), stats.memoryUsage );
+	} );
+}
+
 QList<DocsetInformation> availableDocsets( const QString& docsetsPath )
 {
 	QList<DocsetInformation> docsets;
 
+	scanDocsets( docsetsPath, docsetDatabaseProfile(), Zeal::Registry::CancellationToken{},
+		     [&docsets]( const DocsetInformation& docset ) { docsets << docset; } );
+
+	return docsets;
+}
+
+void scanDocsets( const QString&					  docsetsPath,
+		  const Zeal::Util::SQLiteDatabase::Profile&		  profile,
+		  const Zeal::Registry::CancellationToken&		  token,
+		  const std::function<void( const DocsetInformation& )>& found )
+{
 	// Ensure correct file path concatenation using QDir::filePath
 	const QDir	  docsetDir{ docsetsPath };
 	const QStringList docsetFsNames{
 		docsetDir.entryList( QDir::Dirs | QDir::NoDot | QDir::NoDotDot ) };
 
-	// Reserve space in the list for efficiency if known in advance
-	docsets.reserve( docsetFsNames.size() );
-
 	// Iterate over each directory (docset)
 	for ( const auto& docsetFsName : docsetFsNames )
 	{
-		const Zeal::Registry::Docset ds{ docsetDir.filePath( docsetFsName ) };
+		if ( token.isCanceled() ) { return; }
+
+		const Zeal::Registry::Docset ds{ docsetDir.filePath( docsetFsName ), profile };
 
 		// Skip invalid docsets...
 		if ( !ds.isValid() ) { continue; }
-		// ... and store the valid docsets
-		docsets << DocsetInformation{ ds.path(), ds.title(), ds.icon(), ds.isValid() };
+		int symbolCount{ 0 };
+
+		for ( const int count : ds.symbolCounts() ) { symbolCount += count; }
+
+		// ... and report the valid docsets
+		found( DocsetInformation{
+			ds.path(), ds.title(), ds.iconPath(), ds.isValid(), symbolCount,
+			QFileInfo{ QDir( ds.path() ).filePath( QStringLiteral( "Contents/Resources/docSet.dsidx" ) ) }
+				.size() } );
 	}
-	return docsets;
 }
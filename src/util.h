@@ -19,24 +19,57 @@
 
 #pragma once
 
-#include <QIcon>
+#include <registry/cancellationtoken.h>
+#include <util/sqlitedatabase.h>
+
+#include <QHash>
 #include <QList>
 #include <QStringList>
+#include <functional>
 
 /*!
  * \struct DocsetInformation
  * \brief Contains information about a documentation set.
  *
- * This structure holds the path, title, icon, and validity status of a documentation set.
+ * This structure holds the path, title, icon file, and validity status of a documentation set.
  */
 struct DocsetInformation
 {
 	QString path;  /*!< The file path to the documentation set. */
 	QString title; /*!< The title of the documentation set. */
-	QIcon	icon;  /*!< The icon representing the documentation set. */
+	QString iconPath; /*!< The file of the docset's icon, turned into a QIcon on the GUI thread. */
 	bool isValid;  /*!< A flag indicating whether the documentation set is valid. */
+	int	symbolCount = 0; /*!< Number of symbols in the docset's index. */
+	qint64	indexSize   = 0; /*!< Size of the docset's index on disk, in bytes. */
+};
+
+/*!
+ * \struct DocsetStats
+ * \brief What a docset cost the last time a provider loaded it.
+ *
+ * Providers record these when they build their token table, so the config page can
+ * show them without loading anything.
+ */
+struct DocsetStats
+{
+	qint64 loadTime = -1;	   /*!< Time to read the symbols, in ms, -1 if never measured. */
+	qint64 memoryUsage = -1;   /*!< Memory of the symbols in the token table, in bytes, -1 if never measured. */
 };
 
+/*!
+ * \brief Returns the recorded stats of the docset titled \a title.
+ *
+ * Read from the `DocsetStats` subgroup of the plugin's configuration.
+ */
+DocsetStats docsetStats( const QString& title );
+
+/*!
+ * \brief Records the stats of the docset titled \a title.
+ *
+ * Can be called from any thread, the configuration is written on the GUI thread.
+ */
+void storeDocsetStats( const QString& title, const DocsetStats& stats );
+
 /*!
  * \brief Returns the default path where documentation sets are stored.
  * \return The default path for documentation sets.
@@ -55,9 +88,81 @@ QString docsetsPath();
  */
 QStringList enabledDocsets();
 
+/*!
+ * \brief Returns the SQLite performance profile for docset indexes.
+ *
+ * The values come from the plugin's configuration group (`SQLiteMmapSizeMiB`,
+ * `SQLiteCacheSizeKiB`, `SQLiteTempStoreMemory`, `SQLiteQueryOnly` and
+ * `SQLiteImmutable`), with defaults tuned for read-mostly docsets. The cache size is
+ * per docset, each docset splits it between its connections.
+ * \return The profile to open docsets with.
+ */
+Zeal::Util::SQLiteDatabase::Profile docsetDatabaseProfile();
+
+/*!
+ * \brief Returns the memory budget for the symbol tables of all enabled docsets.
+ *
+ * Read from `MemoryBudgetMiB` in the plugin's configuration group, 0 disables the limit.
+ * \return The budget in bytes.
+ */
+qint64 providerMemoryBudget();
+
+/*!
+ * \brief Returns the memory for pages inflated from archived docsets.
+ *
+ * Read from `ArchiveCacheMiB` in the plugin's configuration group.
+ * \return The cache size in bytes.
+ */
+qint64 documentArchiveCacheSize();
+
+/*!
+ * \brief Returns which docset keywords serve which KDevelop language.
+ *
+ * Keys are language names as reported by `ParsingEnvironmentFile::language()`,
+ * values are the docset keywords (`DocSetPlatformFamily`, `DashDocSetKeyword`, ...)
+ * that are relevant to it. Read from the `LanguageKeywords` subgroup of the plugin's
+ * configuration; built-in defaults are used while the subgroup is empty.
+ * \return The mapping, compared case-insensitively.
+ */
+QHash<QString, QStringList> languageKeywords();
+
+/*!
+ * \brief Checks whether all enabled docsets are served by one aggregated provider.
+ *
+ * Read from `AggregateDocsets` in the plugin's configuration group, off by default.
+ */
+bool aggregateDocsets();
+
+/*!
+ * \brief Returns the priority of each docset in aggregated mode, by title.
+ *
+ * Read from the `DocsetPriorities` subgroup of the plugin's configuration. Docsets
+ * without an entry have priority 0; a higher priority wins a token shared by docsets.
+ */
+QHash<QString, int> docsetPriorities();
+
 /*!
  * \brief Returns a list of available documentation sets.
+ *
+ * Reads the configuration, so it is meant for the GUI thread.
+ *
  * \param docsetsPath The path to search for documentation sets. Defaults to the current documentation path.
  * \return A list of DocsetInformation structures representing the available documentation sets.
  */
 QList<DocsetInformation> availableDocsets( const QString& docsetsPath = docsetsPath() );
+
+/*!
+ * \brief Calls \a found with every valid documentation set in \a docsetsPath, as soon as it is opened.
+ *
+ * Opening a docset reads its database, so this is meant to run off the GUI thread.
+ * The configuration isn't thread-safe, so the caller reads \a profile beforehand.
+ *
+ * \param docsetsPath The path to search for documentation sets.
+ * \param profile The profile to open the docsets with, from docsetDatabaseProfile().
+ * \param token Stops the scan between two docsets once cancelled.
+ * \param found Called on the scanning thread.
+ */
+void scanDocsets( const QString&					  docsetsPath,
+		  const Zeal::Util::SQLiteDatabase::Profile&		  profile,
+		  const Zeal::Registry::CancellationToken&		  token,
+		  const std::function<void( const DocsetInformation& )>& found );
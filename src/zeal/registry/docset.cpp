@@ -24,26 +24,56 @@
 
 #include "docset.h"
 
+#include <debug.h>
 #include <sqlite3.h>
 #include <util/plist.h>
 #include <util/sqlitedatabase.h>
+#include <util/trace.h>
 
 #include <QDir>
 #include <QFile>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMutexLocker>
 #include <QRegularExpression>
+#include <QThread>
 #include <QVariant>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "cancellationtoken.h"
+#include "documentarchive.h"
 #include "searchresult.h"
+#include "searchscore.h"
 
 static void scoreFunc( sqlite3_context* context, int, sqlite3_value** argv );
 
 namespace {
 const char IndexNamePrefix[]  = "__zi_name";	// zi - Zeal index
-const char IndexNameVersion[] = "0001";		// Current index version
+const char IndexNameVersion[] = "0001";		// Current index version, Zeal drops any other
+const char TypeIndexName[]    = "__kzi_type_name0001"; // kzi - ours, Zeal leaves it alone
+
+// Orders UTF-8 names like SQLite's NOCASE collation, which only folds ASCII letters
+int compareNoCase( const QByteArray& a, const QByteArray& b )
+{
+	const int size{ qMin( a.size(), b.size() ) };
+
+	for ( int i = 0; i < size; ++i )
+	{
+		const auto x{ static_cast<unsigned char>( a.at( i ) ) };
+		const auto y{ static_cast<unsigned char>( b.at( i ) ) };
+		const int  fx{ x >= 'A' && x <= 'Z' ? x + 32 : x };
+		const int  fy{ y >= 'A' && y <= 'Z' ? y + 32 : y };
+
+		if ( fx != fy ) { return fx - fy; }
+	}
+
+	return a.size() - b.size();
+}
 
 namespace InfoPlist {
 const char CFBundleName[] = "CFBundleName";
@@ -56,13 +86,42 @@ const char DocSetPlatformFamily[]    = "DocSetPlatformFamily";
 // const char IsDashDocset[] = "isDashDocset";
 // const char IsJavaScriptEnabled[] = "isJavaScriptEnabled";
 }    // namespace InfoPlist
+
+/*!
+ * \brief Remembers the parsed form of the raw symbol types seen by one query.
+ *
+ * Docsets only use a few dozen type strings, so a row costs a short scan over UTF-8
+ * views instead of a QString conversion and a hash lookup.
+ */
+class SymbolTypeCache
+{
+public:
+	template<typename Parser>
+	const QString& get( std::string_view raw, Parser parse )
+	{
+		for ( const auto& entry : m_entries )
+		{
+			if ( entry.first == raw ) { return entry.second; }
+		}
+
+		m_entries.emplace_back(
+			std::string{ raw },
+			parse( QString::fromUtf8( raw.data(), static_cast<int>( raw.size() ) ) ) );
+		return m_entries.back().second;
+	}
+
+private:
+	std::vector<std::pair<std::string, QString>> m_entries;
+};
 }    // namespace
 
-Zeal::Registry::Docset::Docset( const QString& path )
+Zeal::Registry::Docset::Docset( const QString& path, const Util::SQLiteDatabase::Profile& profile )
 	: m_path{ path }
 	, m_documentPath{ QDir( m_path ).absoluteFilePath(
 		  QStringLiteral( "Contents/Resources/Documents" ) ) }
 {
+	ZEAL_TRACE_SPAN( "docset", "Docset::open" );
+
 	QDir dir{ m_path };
 
 	if ( !dir.exists() )
@@ -77,7 +136,8 @@ Zeal::Registry::Docset::Docset( const QString& path )
 	for ( const QString& iconFile :
 	      dir.entryList( { QStringLiteral( "icon.*" ) }, QDir::Files ) )
 	{
-		m_icon = QIcon{ dir.absoluteFilePath( iconFile ) };
+		m_iconPath = dir.absoluteFilePath( iconFile );
+		m_icon	   = QIcon{ m_iconPath };
 
 		if ( !m_icon.availableSizes().isEmpty() )
 		{
@@ -99,10 +159,18 @@ Zeal::Registry::Docset::Docset( const QString& path )
 	// /Articles/ConfigFiles.html
 	Util::Plist plist;
 
+	// Only these keys are used, reading stops once they are all found
+	const QStringList plistKeys{ QString::fromUtf8( InfoPlist::CFBundleName ),
+				     QString::fromUtf8( InfoPlist::DashDocSetFamily ),
+				     QString::fromUtf8( InfoPlist::DashDocSetKeyword ),
+				     QString::fromUtf8( InfoPlist::DashDocSetPluginKeyword ),
+				     QString::fromUtf8( InfoPlist::DashIndexFilePath ),
+				     QString::fromUtf8( InfoPlist::DocSetPlatformFamily ) };
+
 	if ( dir.exists( QStringLiteral( "Info.plist" ) ) )
-		plist.read( dir.absoluteFilePath( QStringLiteral( "Info.plist" ) ) );
+		plist.read( dir.absoluteFilePath( QStringLiteral( "Info.plist" ) ), plistKeys );
 	else if ( dir.exists( QStringLiteral( "info.plist" ) ) )
-		plist.read( dir.absoluteFilePath( QStringLiteral( "info.plist" ) ) );
+		plist.read( dir.absoluteFilePath( QStringLiteral( "info.plist" ) ), plistKeys );
 	else
 		return;
 
@@ -147,8 +215,23 @@ Zeal::Registry::Docset::Docset( const QString& path )
 	     || !dir.exists( QStringLiteral( "docSet.dsidx" ) ) )
 		return;
 
+	// The cache in the profile is the docset's, split between the writer and the most
+	// readers the pool keeps. Maps of the same file share their pages, so those aren't.
+	const int			readerCount{ QThread::idealThreadCount() };
+	Util::SQLiteDatabase::Profile	readerProfile{ profile };
+	readerProfile.cacheSize = profile.cacheSize / ( readerCount + 1 );
+
+	if ( readerProfile.cacheSize == 0 ) { readerProfile.cacheSize = profile.cacheSize < 0 ? -1 : 1; }
+
+	// The read-write connection maintains our index, so it can't be query-only
+	Util::SQLiteDatabase::Profile writerProfile{ readerProfile };
+	writerProfile.queryOnly = false;
+	writerProfile.immutable = false;
+
 	m_db.reset( std::make_unique<Util::SQLiteDatabase>(
-			    dir.absoluteFilePath( QStringLiteral( "docSet.dsidx" ) ) )
+			    dir.absoluteFilePath( QStringLiteral( "docSet.dsidx" ) ),
+			    Util::SQLiteDatabase::OpenMode::ReadWrite,
+			    writerProfile )
 			    .release() );
 
 	if ( !m_db->isOpen() )
@@ -164,10 +247,35 @@ Zeal::Registry::Docset::Docset( const QString& path )
 
 	createIndex();
 
+	qCDebug( KDEV_ZEALDOC ) << "SQLite writer settings for" << dir.absoluteFilePath( QStringLiteral( "docSet.dsidx" ) )
+				<< ":" << m_db->effectiveProfile();
+
+	// Queries run on pooled read-only connections, opened on first use. The read-write
+	// one above is only needed for maintaining our index.
+	m_readers = std::make_unique<Util::SQLiteConnectionPool>(
+		dir.absoluteFilePath( QStringLiteral( "docSet.dsidx" ) ),
+		readerProfile,
+		readerCount,
+		[]( Util::SQLiteDatabase& db ) {
+			sqlite3_create_function( db.handle(), "zealScore", 2, SQLITE_UTF8, nullptr, scoreFunc, nullptr, nullptr );
+
+			qCDebug( KDEV_ZEALDOC ) << "SQLite reader settings:" << db.effectiveProfile();
+		} );
+
 	if ( !dir.cd( QStringLiteral( "Documents" ) ) )
 	{
-		m_type = Type::Invalid;
-		return;
+		if ( dir.exists( DocumentArchive::fileName() ) )
+		{
+			m_archive = DocumentArchive::open( dir.absoluteFilePath( DocumentArchive::fileName() ) );
+		}
+
+		if ( !m_archive )
+		{
+			m_type = Type::Invalid;
+			return;
+		}
+
+		m_documentPath = m_archive->documentPath();
 	}
 
 	// Setup keywords
@@ -199,9 +307,14 @@ Zeal::Registry::Docset::Docset( const QString& path )
 		m_indexFileUrl = createPageUrl(
 			plist[QString::fromUtf8( InfoPlist::DashIndexFilePath )].toString() );
 	}
-	else if ( m_indexFileUrl.isEmpty() )
+	else if ( !m_metadataIndexFilePath.isEmpty() )
+	{
+		m_indexFileUrl = createPageUrl( m_metadataIndexFilePath );
+	}
+	else
 	{
-		if ( dir.exists( QStringLiteral( "index.html" ) ) )
+		if ( m_archive ? m_archive->contains( QStringLiteral( "index.html" ) )
+			       : dir.exists( QStringLiteral( "index.html" ) ) )
 			m_indexFileUrl =
 				createPageUrl( QStringLiteral( "index.html" ) );
 		else
@@ -232,6 +345,8 @@ QString Zeal::Registry::Docset::documentPath() const { return m_documentPath; }
 
 QIcon Zeal::Registry::Docset::icon() const { return m_icon; }
 
+QString Zeal::Registry::Docset::iconPath() const { return m_iconPath; }
+
 QIcon Zeal::Registry::Docset::symbolTypeIcon( const QString& symbolType ) const
 {
 	static const QIcon unknownIcon{ QStringLiteral( "typeIcon:Unknown.png" ) };
@@ -254,67 +369,216 @@ int Zeal::Registry::Docset::symbolCount( const QString& symbolType ) const
 
 const QMap<QString, QUrl>& Zeal::Registry::Docset::symbols( const QString& symbolType ) const
 {
+	const QMutexLocker locker{ &m_symbolsMutex };
+
 	if ( !m_symbols.contains( symbolType ) ) { loadSymbols( symbolType ); }
 
+	// QMap nodes stay put when other types are inserted later
 	return m_symbols[symbolType];
 }
 
+Zeal::Registry::Docset::SymbolCursor Zeal::Registry::Docset::symbolCursor( const QString& symbolType ) const
+{
+	return SymbolCursor{ this, symbolType };
+}
+
+Zeal::Registry::Docset::SymbolCursor::SymbolCursor( const Docset* docset, const QString& symbolType )
+	: m_docset{ docset }
+	, m_symbolType{ symbolType }
+	, m_atEnd{ !docset->m_symbolStrings.contains( symbolType ) }
+{}
+
+bool Zeal::Registry::Docset::SymbolCursor::atEnd() const { return m_atEnd; }
+
+QList<Zeal::Registry::SearchResult> Zeal::Registry::Docset::SymbolCursor::fetch( int count )
+{
+	QList<SearchResult> results;
+
+	if ( m_atEnd || count <= 0 ) { return results; }
+
+	ZEAL_TRACE_SPAN( "docset", "SymbolCursor::fetch" );
+
+	// A type spread over several raw type strings gets one ordered range per string,
+	// merged below. Filtering all of them at once would need SQLite to sort the rest
+	// of the type on every page.
+	const QStringList typeStrings{ m_docset->m_symbolStrings.values( m_symbolType ) };
+
+	// The type and the leading >= give SQLite a range on the (type, name) index, the
+	// OR term then skips the rows up to and including the last one we returned.
+	QString queryStr;
+
+	if ( m_docset->m_type == Docset::Type::Dash )
+	{
+		queryStr = QStringLiteral( "SELECT name, path, '', rowid FROM searchIndex "
+					   "WHERE type = ?4 "
+					   "AND name >= ?1 COLLATE NOCASE "
+					   "AND (name > ?1 COLLATE NOCASE OR rowid > ?2) "
+					   "ORDER BY name COLLATE NOCASE, rowid "
+					   "LIMIT ?3" );
+	}
+	else
+	{
+		queryStr = QStringLiteral(
+			"SELECT ztokenname, zpath, zanchor, ztoken.rowid "
+			"FROM ztoken "
+			"LEFT JOIN ztokenmetainformation ON ztoken.zmetainformation = "
+			"ztokenmetainformation.z_pk "
+			"LEFT JOIN zfilepath ON ztokenmetainformation.zfile = "
+			"zfilepath.z_pk "
+			"WHERE ztoken.ztokentype = ?4 "
+			"AND ztokenname >= ?1 COLLATE NOCASE "
+			"AND (ztokenname > ?1 COLLATE NOCASE OR ztoken.rowid > ?2) "
+			"ORDER BY ztokenname COLLATE NOCASE, ztoken.rowid "
+			"LIMIT ?3" );
+	}
+
+	const auto db{ m_docset->m_readers ? m_docset->m_readers->acquire()
+					   : Util::SQLiteConnectionPool::Lease{} };
+
+	struct Row
+	{
+		QByteArray name;
+		QString	   path;
+		QString	   fragment;
+		qint64	   rowId;
+	};
+
+	std::vector<Row> rows;
+
+	for ( const QString& typeString : typeStrings )
+	{
+		// SQLite only keeps to the (type, name) index for a type key it knows up front
+		qint64 typeId{ -1 };
+
+		if ( db && m_docset->m_type == Docset::Type::ZDash
+		     && db->prepare( QStringLiteral( "SELECT z_pk FROM ztokentype WHERE ztypename = ?1" ) ) )
+		{
+			db->bindText( 1, typeString );
+
+			if ( !db->next() ) { continue; }
+
+			typeId = db->int64Value( 0 );
+		}
+
+		if ( !db || !db->prepare( queryStr ) )
+		{
+			if ( db ) { qWarning( "SQL Error: %s", qPrintable( db->lastError() ) ); }
+
+			m_atEnd = true;
+			return results;
+		}
+
+		db->bindText( 1, m_lastName );
+		db->bindInt64( 2, m_lastRowId );
+		db->bindInt64( 3, count );
+
+		if ( m_docset->m_type == Docset::Type::Dash ) { db->bindText( 4, typeString ); }
+		else { db->bindInt64( 4, typeId ); }
+
+		while ( db->next() )
+		{
+			const std::string_view name{ db->utf8Value( 0 ) };
+
+			rows.push_back( { QByteArray( name.data(), static_cast<int>( name.size() ) ),
+					  db->stringValue( 1 ),
+					  db->stringValue( 2 ),
+					  db->int64Value( 3 ) } );
+		}
+	}
+
+	// Each range is already in order, only their merge is left
+	if ( typeStrings.size() > 1 )
+	{
+		std::sort( rows.begin(), rows.end(), []( const Row& a, const Row& b ) {
+			const int order{ compareNoCase( a.name, b.name ) };
+			return order != 0 ? order < 0 : a.rowId < b.rowId;
+		} );
+	}
+
+	// Fewer rows than asked for across all ranges means they are all exhausted
+	const bool exhausted{ static_cast<int>( rows.size() ) < count };
+
+	if ( !exhausted ) { rows.resize( count ); }
+
+	results.reserve( static_cast<int>( rows.size() ) );
+
+	for ( const Row& row : rows )
+	{
+		results.append( { QString::fromUtf8( row.name ),
+				  m_symbolType,
+				  const_cast<Docset*>( m_docset ),
+				  m_docset->createPageUrl( row.path, row.fragment ),
+				  0 } );
+		m_lastRowId = row.rowId;
+	}
+
+	if ( !results.isEmpty() ) { m_lastName = results.constLast().name; }
+
+	m_atEnd = exhausted;
+	return results;
+}
+
 QList<Zeal::Registry::SearchResult> Zeal::Registry::Docset::search( const QString& query,
 								    const CancellationToken& token ) const
 {
-	// Make it safe to use in a SQL query.
-	QString sanitizedQuery{ query };
-	sanitizedQuery.replace( QLatin1String( "\\" ), QLatin1String( "\\\\" ) );
-	sanitizedQuery.replace( QLatin1String( "_" ), QLatin1String( "\\_" ) );
-	sanitizedQuery.replace( QLatin1String( "%" ), QLatin1String( "\\%" ) );
-	sanitizedQuery.replace( QLatin1String( "'" ), QLatin1String( "''" ) );
+	ZEAL_TRACE_SPAN( "docset", "Docset::search" );
 
 	QString queryStr;
 
 	if ( m_type == Docset::Type::Dash )
 	{
 		queryStr = QStringLiteral( "SELECT name, type, path, '', "
-					   "zealScore('%1', name) as score "
+					   "zealScore(?1, name) as score "
 					   "    FROM searchIndex "
 					   "WHERE score > 0 "
-					   "ORDER BY score DESC" )
-				   .arg( sanitizedQuery );
+					   "ORDER BY score DESC "
+					   "LIMIT ?2" );
 	}
 	else
 	{
-		queryStr =
-			QStringLiteral(
-				"SELECT ztokenname, ztypename, zpath, zanchor, "
-				"zealScore('%1', ztokenname) as score "
-				"    FROM ztoken "
-				"LEFT JOIN ztokenmetainformation "
-				"    ON ztoken.zmetainformation = "
-				"ztokenmetainformation.z_pk "
-				"LEFT JOIN zfilepath "
-				"    ON ztokenmetainformation.zfile = zfilepath.z_pk "
-				"LEFT JOIN ztokentype "
-				"    ON ztoken.ztokentype = ztokentype.z_pk "
-				"WHERE score > 0 "
-				"ORDER BY score DESC" )
-				.arg( sanitizedQuery );
-	}
-
-	// Limit for very short queries.
-	// TODO: Show a notification about the reduced result set.
-	if ( query.size() < 3 ) { queryStr = QLatin1String( " LIMIT 1000" ); }
+		queryStr = QStringLiteral(
+			"SELECT ztokenname, ztypename, zpath, zanchor, "
+			"zealScore(?1, ztokenname) as score "
+			"    FROM ztoken "
+			"LEFT JOIN ztokenmetainformation "
+			"    ON ztoken.zmetainformation = "
+			"ztokenmetainformation.z_pk "
+			"LEFT JOIN zfilepath "
+			"    ON ztokenmetainformation.zfile = zfilepath.z_pk "
+			"LEFT JOIN ztokentype "
+			"    ON ztoken.ztokentype = ztokentype.z_pk "
+			"WHERE score > 0 "
+			"ORDER BY score DESC "
+			"LIMIT ?2" );
+	}
 
 	QList<SearchResult> results;
 
-	m_db->execute( queryStr );
+	const auto db{ m_readers ? m_readers->acquire() : Util::SQLiteConnectionPool::Lease{} };
 
-	while ( m_db->next() && !token.isCanceled() )
+	if ( !db ) { return results; }
+
+	if ( !db->prepare( queryStr ) )
 	{
-		results.append( { m_db->value( 0 ).toString(),
-				  parseSymbolType( m_db->value( 1 ).toString() ),
+		qWarning( "SQL Error: %s", qPrintable( db->lastError() ) );
+		return results;
+	}
+
+	db->bindText( 1, query );
+
+	// Limit for very short queries, a negative limit means no limit at all.
+	// TODO: Show a notification about the reduced result set.
+	db->bindInt64( 2, query.size() < 3 ? 1000 : -1 );
+
+	SymbolTypeCache symbolTypes;
+
+	while ( db->next() && !token.isCanceled() )
+	{
+		results.append( { db->stringValue( 0 ),
+				  symbolTypes.get( db->utf8Value( 1 ), parseSymbolType ),
 				  const_cast<Docset*>( this ),
-				  createPageUrl( m_db->value( 2 ).toString(),
-						 m_db->value( 3 ).toString() ),
-				  m_db->value( 4 ).toInt() } );
+				  createPageUrl( db->stringValue( 2 ), db->stringValue( 3 ) ),
+				  static_cast<int>( db->int64Value( 4 ) ) } );
 	}
 
 	return results;
@@ -324,8 +588,8 @@ QList<Zeal::Registry::SearchResult> Zeal::Registry::Docset::relatedLinks( const
 {
 	QList<SearchResult> results;
 
-	// Strip docset path and anchor from url
-	const QString dir{ documentPath() };
+	// Strip docset path and anchor from url, archived pages have no docset path in theirs
+	const QString dir{ m_archive ? QString{} : documentPath() };
 	const QString urlPath{ url.path() };
 	const int     dirPosition{ urlPath.indexOf( dir ) };
 	const QString path{ url.path().mid( dirPosition + dir.size() + 1 ) };
@@ -339,9 +603,10 @@ QList<Zeal::Registry::SearchResult> Zeal::Registry::Docset::relatedLinks( const
 
 	if ( m_type == Docset::Type::Dash )
 	{
-		queryStr =
-			QStringLiteral( "SELECT name, type, path FROM searchIndex "
-					"WHERE path LIKE \"%1%%\" AND path <> \"%1\"" );
+		// Dash keeps the anchor in the path, so match on the path prefix.
+		queryStr = QStringLiteral( "SELECT name, type, path FROM searchIndex "
+					   "WHERE substr(path, 1, length(?1)) = ?1 "
+					   "AND path <> ?1" );
 	}
 	else if ( m_type == Docset::Type::ZDash )
 	{
@@ -354,19 +619,30 @@ QList<Zeal::Registry::SearchResult> Zeal::Registry::Docset::relatedLinks( const
 			"LEFT JOIN zfilepath ON ztokenmetainformation.zfile = "
 			"zfilepath.z_pk "
 			"LEFT JOIN ztokentype ON ztoken.ztokentype = ztokentype.z_pk "
-			"WHERE zfilepath.zpath = \"%1\" AND "
+			"WHERE zfilepath.zpath = ?1 AND "
 			"ztokenmetainformation.zanchor IS NOT NULL" );
 	}
 
-	m_db->execute( queryStr.arg( cleanUrl.toString() ) );
+	const auto db{ m_readers ? m_readers->acquire() : Util::SQLiteConnectionPool::Lease{} };
 
-	while ( m_db->next() )
+	if ( !db ) { return results; }
+
+	if ( !db->prepare( queryStr ) )
 	{
-		results.append( { m_db->value( 0 ).toString(),
-				  parseSymbolType( m_db->value( 1 ).toString() ),
+		qWarning( "SQL Error: %s", qPrintable( db->lastError() ) );
+		return results;
+	}
+
+	db->bindText( 1, cleanUrl.toString() );
+
+	SymbolTypeCache symbolTypes;
+
+	while ( db->next() )
+	{
+		results.append( { db->stringValue( 0 ),
+				  symbolTypes.get( db->utf8Value( 1 ), parseSymbolType ),
 				  const_cast<Docset*>( this ),
-				  createPageUrl( m_db->value( 2 ).toString(),
-						 m_db->value( 3 ).toString() ),
+				  createPageUrl( db->stringValue( 2 ), db->stringValue( 3 ) ),
 				  0 } );
 	}
 
@@ -416,10 +692,10 @@ void Zeal::Registry::Docset::loadMetadata()
 	{
 		const QJsonObject extra = jsonObject[QStringLiteral( "extra" )].toObject();
 
+		// Resolved once the documents are located, they may be archived
 		if ( extra.contains( QStringLiteral( "indexFilePath" ) ) )
 		{
-			m_indexFileUrl = createPageUrl(
-				extra[QStringLiteral( "indexFilePath" )].toString() );
+			m_metadataIndexFilePath = extra[QStringLiteral( "indexFilePath" )].toString();
 		}
 
 		if ( extra.contains( QStringLiteral( "keywords" ) ) )
@@ -433,6 +709,8 @@ void Zeal::Registry::Docset::loadMetadata()
 
 void Zeal::Registry::Docset::countSymbols()
 {
+	ZEAL_TRACE_SPAN( "docset", "Docset::countSymbols" );
+
 	QString queryStr;
 
 	if ( m_type == Docset::Type::Dash )
@@ -447,7 +725,7 @@ void Zeal::Registry::Docset::countSymbols()
 			" ON ztoken.ztokentype = ztokentype.z_pk GROUP BY ztypename" );
 	}
 
-	if ( !m_db->execute( queryStr ) )
+	if ( !m_db->prepare( queryStr ) )
 	{
 		qWarning( "SQL Error: %s", qPrintable( m_db->lastError() ) );
 		return;
@@ -455,29 +733,60 @@ void Zeal::Registry::Docset::countSymbols()
 
 	while ( m_db->next() )
 	{
-		const QString symbolTypeStr = m_db->value( 0 ).toString();
+		const QString symbolTypeStr = m_db->stringValue( 0 );
 		const QString symbolType    = parseSymbolType( symbolTypeStr );
 		m_symbolStrings.insert( symbolType, symbolTypeStr );
-		m_symbolCounts[symbolType] = m_db->value( 1 ).toInt();
+		m_symbolCounts[symbolType] = static_cast<int>( m_db->int64Value( 1 ) );
 	}
 }
 
 // TODO: Fetch and cache only portions of symbols
 void Zeal::Registry::Docset::loadSymbols( const QString& symbolType ) const
 {
+	ZEAL_TRACE_SPAN( "docset", "Docset::loadSymbols" );
+
+	const auto db{ m_readers ? m_readers->acquire() : Util::SQLiteConnectionPool::Lease{} };
+
+	// Keep an empty entry anyway, so a broken docset is not queried over and over
+	if ( !db )
+	{
+		m_symbols[symbolType];
+		return;
+	}
+
+	QMultiMap<QString, QUrl>& symbols = m_symbols[symbolType];
+
 	for ( const QString& symbol : m_symbolStrings.values( symbolType ) )
-		loadSymbols( symbolType, symbol );
+	{
+		readSymbols( *db, symbol, [&]( const QString& name, const PageLocation& location ) {
+			symbols.insert( name, pageUrl( documentPath(), location ) );
+		} );
+	}
+}
+
+void Zeal::Registry::Docset::forEachSymbol(
+	const QString&							     symbolType,
+	const std::function<void( const QString& name, const PageLocation& location )>& f ) const
+{
+	ZEAL_TRACE_SPAN( "docset", "Docset::forEachSymbol" );
+
+	const auto db{ m_readers ? m_readers->acquire() : Util::SQLiteConnectionPool::Lease{} };
+
+	if ( !db ) { return; }
+
+	for ( const QString& symbol : m_symbolStrings.values( symbolType ) ) readSymbols( *db, symbol, f );
 }
 
-void Zeal::Registry::Docset::loadSymbols( const QString& symbolType,
-					  const QString& symbolString ) const
+void Zeal::Registry::Docset::readSymbols( Util::SQLiteDatabase&					   db,
+					  const QString&					   symbolString,
+					  const std::function<void( const QString&, const PageLocation& )>& f ) const
 {
 	QString queryStr;
 
 	if ( m_type == Docset::Type::Dash )
 	{
 		queryStr = QStringLiteral( "SELECT name, path FROM searchIndex WHERE "
-					   "type='%1' ORDER BY name ASC" );
+					   "type = ?1 ORDER BY name ASC" );
 	}
 	else
 	{
@@ -489,33 +798,35 @@ void Zeal::Registry::Docset::loadSymbols( const QString& symbolType,
 			"LEFT JOIN zfilepath ON ztokenmetainformation.zfile = "
 			"zfilepath.z_pk "
 			"LEFT JOIN ztokentype ON ztoken.ztokentype = ztokentype.z_pk "
-			"WHERE ztypename='%1' "
+			"WHERE ztypename = ?1 "
 			"ORDER BY ztokenname ASC" );
 	}
 
-	if ( !m_db->execute( queryStr.arg( symbolString ) ) )
+	if ( !db.prepare( queryStr ) )
 	{
-		qWarning( "SQL Error: %s", qPrintable( m_db->lastError() ) );
+		qWarning( "SQL Error: %s", qPrintable( db.lastError() ) );
 		return;
 	}
 
-	QMultiMap<QString, QUrl>& symbols = m_symbols[symbolType];
+	db.bindText( 1, symbolString );
 
-	while ( m_db->next() )
-		symbols.insert( m_db->value( 0 ).toString(),
-				createPageUrl( m_db->value( 1 ).toString(),
-					       m_db->value( 2 ).toString() ) );
+	while ( db.next() ) f( db.stringValue( 0 ), pageLocation( db.stringValue( 1 ), db.stringValue( 2 ) ) );
 }
 
 void Zeal::Registry::Docset::createIndex()
 {
+	ZEAL_TRACE_SPAN( "docset", "Docset::createIndex" );
+
 	// Define SQL queries for index operations
 	static const QString indexListQuery{
-		QStringLiteral( "PRAGMA INDEX_LIST('%1')" ) };
+		QStringLiteral( "SELECT name FROM pragma_index_list(?1)" ) };
 	static const QString indexDropQuery{ QStringLiteral( "DROP INDEX '%1'" ) };
 	static const QString indexCreateQuery{
 		QStringLiteral( "CREATE INDEX IF NOT EXISTS %1%2"
 				" ON %3 (%4 COLLATE NOCASE)" ) };
+	static const QString typeIndexCreateQuery{
+		QStringLiteral( "CREATE INDEX IF NOT EXISTS %1"
+				" ON %2 (%3, %4 COLLATE NOCASE)" ) };
 
 	// Determine table and column names based on docset type
 	const QString tableName{ m_type == Type::Dash ? QStringLiteral( "searchIndex" )
@@ -523,84 +834,151 @@ void Zeal::Registry::Docset::createIndex()
 	const QString columnName{ m_type == Type::Dash
 					  ? QStringLiteral( "name" )
 					  : QStringLiteral( "ztokenname" ) };
+	const QString typeColumnName{ m_type == Type::Dash ? QStringLiteral( "type" )
+							   : QStringLiteral( "ztokentype" ) };
+
+	// execute() only compiles a statement, schema changes happen on the step
+	const auto run = [this]( const QString& queryStr ) {
+		if ( m_db->execute( queryStr ) && !m_db->next() && sqlite3_errcode( m_db->handle() ) != SQLITE_DONE )
+		{
+			qWarning( "SQL Error: %s", qPrintable( m_db->lastError() ) );
+		}
+	};
 
 	// Query to list existing indexes on the selected table
-	m_db->execute( indexListQuery.arg( tableName ) );
+	if ( !m_db->prepare( indexListQuery ) ) return;
+
+	m_db->bindText( 1, tableName );
 
 	QStringList oldIndexes;	   // To store the names of outdated indexes
+	bool	    hasNameIndex{ false };
+	bool	    hasTypeIndex{ false };
 
 	// Iterate over the results of the index list query
 	while ( m_db->next() )
 	{
-		const QString indexName{ m_db->value( 1 ).toString() };	   // Get the index name from the query result
+		const std::string_view indexName{ m_db->utf8Value( 0 ) };    // Get the index name from the query result
+
+		if ( indexName == TypeIndexName ) { hasTypeIndex = true; }
 
 		// Skip indexes that do not belong to Zeal (not starting with the expected prefix)
-		if ( !indexName.startsWith( QString::fromLocal8Bit( IndexNamePrefix ) ) )
-			continue;
+		if ( !indexName.starts_with( IndexNamePrefix ) ) continue;
 
-		// If the index matches the current version, no further action is needed
-		if ( indexName.endsWith( QString::fromLocal8Bit( IndexNameVersion ) ) )
-			return;
+		// If the index matches the current version, it stays
+		if ( indexName.ends_with( IndexNameVersion ) )
+		{
+			hasNameIndex = true;
+			continue;
+		}
 
 		// Add outdated index names to the list for removal
-		oldIndexes << indexName;
+		oldIndexes << QString::fromUtf8( indexName.data(),
+						 static_cast<int>( indexName.size() ) );
 	}
 
+	if ( hasNameIndex && hasTypeIndex && oldIndexes.isEmpty() ) return;
+
+	// Docsets on read-only storage are served without the indexes, just slower
+	if ( sqlite3_db_readonly( m_db->handle(), "main" ) == 1 )
+	{
+		qCDebug( KDEV_ZEALDOC ) << "Docset database is read-only, not indexing"
+					<< sqlite3_db_filename( m_db->handle(), "main" );
+		return;
+	}
+
+	// Schema statements can't take bound identifiers, the names below are our own
+	// constants or come straight from sqlite_master.
+
 	// Drop all outdated indexes
 	for ( const QString& oldIndexName : oldIndexes )
-		m_db->execute( indexDropQuery.arg( oldIndexName ) );
+		run( indexDropQuery.arg( oldIndexName ) );
+
+	// Create a new index for the table on the specified column, using case-insensitive collation.
+	// Named and versioned like Zeal's own, so the two share it.
+	if ( !hasNameIndex )
+	{
+		run( indexCreateQuery.arg( QString::fromLocal8Bit( IndexNamePrefix ),
+					   QString::fromLocal8Bit( IndexNameVersion ),
+					   tableName,
+					   columnName ) );
+	}
 
-	// Create a new index for the table on the specified column, using case-insensitive collation
-	m_db->execute( indexCreateQuery.arg( QString::fromLocal8Bit( IndexNamePrefix ),
-					     QString::fromLocal8Bit( IndexNameVersion ),
-					     tableName,
-					     columnName ) );
+	// Symbol cursors filter by type, then walk the names in order
+	if ( !hasTypeIndex )
+	{
+		run( typeIndexCreateQuery.arg( QString::fromLocal8Bit( TypeIndexName ),
+					       tableName,
+					       typeColumnName,
+					       columnName ) );
+	}
 }
 
 QUrl Zeal::Registry::Docset::createPageUrl( const QString& path, const QString& fragment ) const
 {
-	QString realPath;
-	QString realFragment;
+	return pageUrl( documentPath(), pageLocation( path, fragment ) );
+}
+
+Zeal::Registry::Docset::PageLocation Zeal::Registry::Docset::pageLocation( const QString& path,
+									  const QString& fragment )
+{
+	PageLocation location;
 
 	// Handle cases where the fragment is part of the path (separated by '#')
 	if ( fragment.isEmpty() )
 	{
-		const QStringList urlParts{ path.split( QLatin1Char( '#' ) ) };
-		realPath = urlParts[0];	   // Extract the main path
+		const int hashPosition{ path.indexOf( QLatin1Char( '#' ) ) };
+		location.path = path.left( hashPosition );    // Extract the main path
 
 		// If there is a fragment part, extract it
-		if ( urlParts.size() > 1 ) realFragment = urlParts[1];
+		if ( hashPosition >= 0 )
+		{
+			location.fragment = path.mid( hashPosition + 1 ).section( QLatin1Char( '#' ), 0, 0 );
+		}
 	}
 	else
 	{
 		// Use the provided path and fragment directly
-		realPath     = path;
-		realFragment = fragment;
+		location.path	  = path;
+		location.fragment = fragment;
 	}
 
 	// Remove special Dash-specific placeholders from the path and fragment
+	// Only a few docsets use them, so skip the regular expression for everybody else.
 	static const QRegularExpression dashEntryRegExp{
 		QLatin1String{ "<dash_entry_.*>" } };
-	realPath.remove( dashEntryRegExp );
-	realFragment.remove( dashEntryRegExp );
+	static const QLatin1String dashEntryTag{ "<dash_entry_" };
+
+	if ( location.path.contains( dashEntryTag ) ) location.path.remove( dashEntryRegExp );
+	if ( location.fragment.contains( dashEntryTag ) ) location.fragment.remove( dashEntryRegExp );
 
-	// Construct a file-based URL pointing to the document path
-	QUrl url{ QUrl::fromLocalFile( QDir( documentPath() ).absoluteFilePath( realPath ) ) };
+	// Dash/Apple-style fragments are set decoded
+	location.decodedFragment = location.fragment.startsWith( QLatin1String( "//apple_ref" ) )
+				   || location.fragment.startsWith( QLatin1String( "//dash_ref" ) );
+
+	return location;
+}
+
+QUrl Zeal::Registry::Docset::pageUrl( const QString& documentPath, const PageLocation& location )
+{
+	QUrl url;
+
+	if ( DocumentArchive::isArchivePath( documentPath ) )
+	{
+		// Archived pages keep their path below the archive's URL
+		url = QUrl{ documentPath };
+		url.setPath( QDir::cleanPath( QLatin1Char( '/' ) + location.path ), QUrl::DecodedMode );
+	}
+	else
+	{
+		// Construct a file-based URL pointing to the document path
+		url = QUrl::fromLocalFile( QDir( documentPath ).absoluteFilePath( location.path ) );
+	}
 
 	// Set the fragment (anchor) for the URL if available
-	if ( !realFragment.isEmpty() )
+	if ( !location.fragment.isEmpty() )
 	{
-		// Special handling for Dash/Apple-style fragments (decode them)
-		if ( realFragment.startsWith( QLatin1String( "//apple_ref" ) )
-		     || realFragment.startsWith( QLatin1String( "//dash_ref" ) ) )
-		{
-			url.setFragment( realFragment, QUrl::DecodedMode );
-		}
-		else
-		{
-			// Set a regular fragment
-			url.setFragment( realFragment );
-		}
+		url.setFragment( location.fragment,
+				 location.decodedFragment ? QUrl::DecodedMode : QUrl::TolerantMode );
 	}
 
 	// Return the fully constructed URL
@@ -740,246 +1118,20 @@ QString Zeal::Registry::Docset::parseSymbolType( const QString& str )
 	return aliases.value( str, str );
 }
 
-// ported from DevDocs' searcher.coffee:
-// (https://github.com/Thibaut/devdocs/blob/50f583246d5fbd92be7b71a50bfa56cf4e239c14/assets/javascripts/app/searcher.coffee#L91)
-static void matchFuzzy( int		     nLen,
-			const unsigned char* needle,
-			int		     hLen,
-			const unsigned char* haystack,
-			int*		     start,
-			int*		     len )
-{
-	const int j	 = 0;
-	int	  groups = 0;
-
-	for ( int i = 0; i < nLen; ++i )
-	{
-		bool found    = false;
-		bool first    = true;
-		int  distance = 0;
-
-		while ( j < hLen )
-		{
-			if ( needle[i] == haystack[j] )
-			{
-				if ( *start == -1 )
-					*start = j - 1;	   // first matched char
-
-				*len  = j - *start;
-				found = true;
-				break;	  // continue the outer loop
-			}
-			else
-			{
-				// optimizations to reduce returned number of results
-				// (search was returning too many irrelevant results with large docsets)
-				if ( first )
-				{
-					groups = 1;
-
-					if ( groups > 3 )    // optimization #1: too many mismatches
-					{
-						break;
-					}
-					first = false;
-				}
-
-				if ( i != 0 )
-				{
-					distance = 1;
-
-					if ( distance > 8 )    // optimization #2: too large distance between found chars
-					{
-						break;
-					}
-				}
-			}
-		}
-
-		if ( !found )
-		{
-			// end of haystack, char not found
-			*start = -1;
-			return;
-		}
-	}
-}
-
-static int scoreExact( int matchIndex, int matchLen, const unsigned char* value, int valueLen )
-{
-	int		    score = 100;
-	const unsigned char DOT	  = '.';
-	// Remove one point for each unmatched character.
-	score -= ( valueLen - matchLen );
-
-	if ( matchIndex > 0 )
-	{
-		if ( value[matchIndex - 1] == DOT )
-		{
-			// If the character preceding the query is a dot, assign the
-			// same score as if the query was found at the beginning of the
-			// string, minus one.
-			score = ( matchIndex - 1 );
-		}
-		else if ( matchLen == 1 )
-		{
-			// Don't match a single-character query unless it's found at the
-			// beginning of the string or is preceded by a dot.
-			return 0;
-		}
-		else
-		{
-			// (1) Remove one point for each unmatched character up to
-			//     the nearest preceding dot or the beginning of the
-			//     string.
-			// (2) Remove one point for each unmatched character
-			//     following the query.
-			int i = matchIndex - 2;
-
-			while ( i >= 0 && value[i] != DOT ) --i;
-
-			score -= ( matchIndex - i ) +			  // (1)
-				 ( valueLen - matchLen - matchIndex );	  // (2)
-		}
-
-		// Remove one point for each dot preceding the query, except for the
-		// one immediately before the query.
-		int separators = 0;
-		int index      = matchIndex - 2;
-
-		while ( index >= 0 )
-		{
-			if ( value[index] == DOT ) ++separators;
-
-			--index;
-		}
-
-		score -= separators;
-	}
-
-	// Remove five points for each dot following the query.
-	int separators = 0;
-	int index      = valueLen - matchLen - matchIndex - 1;
-
-	while ( index >= 0 )
-	{
-		if ( value[matchIndex + matchLen + index] == DOT ) { ++separators; }
-
-		--index;
-	}
-
-	score -= separators * 5;
-
-	return qMax( 1, score );
-}
-
-static int scoreFuzzy( int matchIndex, int matchLen, const unsigned char* value )
-{
-	if ( matchIndex == 0 || value[matchIndex - 1] == '.' )
-	{
-		// score between 66..99, if the match follows a dot, or starts the string
-		return qMax( 66, 100 - matchLen );
-	}
-	else
-	{
-		if ( value[matchIndex + matchLen] == 0 )
-		{
-			// score between 33..66, if the match is at the end of the string
-			return qMax( 33, 67 - matchLen );
-		}
-		else
-		{
-			// score between 1..33 otherwise (match in the middle of the string)
-			return qMax( 1, 34 - matchLen );
-		}
-	}
-}
-
 static void scoreFunc( sqlite3_context* context, int argc, sqlite3_value** argv )
 {
 	Q_UNUSED( argc );
-	const unsigned char* needleOrig	  = sqlite3_value_text( argv[0] );
-	const unsigned char* haystackOrig = sqlite3_value_text( argv[1] );
-
-	int haystackLen = 0, needleLen = 0;
-
-	while ( haystackOrig[haystackLen] != 0 ) { ++haystackLen; }
+	const auto* needle{ sqlite3_value_text( argv[0] ) };
+	const auto* haystack{ sqlite3_value_text( argv[1] ) };
 
-	while ( needleOrig[needleLen] != 0 ) { ++needleLen; }
-
-	const std::unique_ptr<unsigned char[]> needle( new unsigned char[needleLen + 1] );
-	const std::unique_ptr<unsigned char[]> haystack( new unsigned char[haystackLen + 1] );
-
-	for ( int i = 0; i < needleLen + 1; ++i )
+	if ( !needle || !haystack )
 	{
-		unsigned char c = needleOrig[i];
-		if ( c >= 'A' && c <= 'Z' ) { c = 32; }
-		needle[i] = c;
-	}
-
-	for ( int i = 0, j = 0; i < haystackLen + 1; ++i, ++j )
-	{
-		unsigned char c = haystackOrig[i];
-
-		if ( ( i > 0 && haystackOrig[i - 1] == ':' && c == ':' )    // C (::)
-		     || c == '/' || c == '_' || c == ' ' )    // Go, some Guides
-		{
-			haystack[j] = '.';
-		}
-		else
-		{
-			if ( c >= 'A' && c <= 'Z' ) c = 32;
-
-			haystack[j] = c;
-		}
-	}
-
-	int best   = 0;
-	int match1 = -1;
-	int match1Len;
-
-	matchFuzzy( needleLen, needle.get(), haystackLen, haystack.get(), &match1, &match1Len );
-
-	if ( match1 == -1 )    // no match
-	{
-		// simply return 0
 		sqlite3_result_int( context, 0 );
 		return;
 	}
-	else if ( needleLen == match1Len )    // exact match
-	{
-		best = scoreExact( match1, match1Len, haystack.get(), haystackLen );
-	}
-	else
-	{
-		best = scoreFuzzy( match1, match1Len, haystack.get() );
-
-		int indexOfLastDot = -1;
-
-		for ( int i = 0; haystack[i] != 0; ++i )
-		{
-			if ( haystack[i] == '.' ) indexOfLastDot = i;
-		}
 
-		if ( indexOfLastDot != -1 )
-		{
-			int match2 = -1, match2Len;
-			matchFuzzy( needleLen,
-				    needle.get(),
-				    haystackLen - ( indexOfLastDot + 1 ),
-				    haystack.get() + indexOfLastDot + 1,
-				    &match2,
-				    &match2Len );
-
-			if ( match2 != -1 )
-			{
-				best = qMax( best,
-					     scoreFuzzy( match2,
-							 match2Len,
-							 haystack.get() + indexOfLastDot + 1 ) );
-			}
-		}
-	}
+	const int score{ Zeal::Registry::SearchScore::score(
+		needle, sqlite3_value_bytes( argv[0] ), haystack, sqlite3_value_bytes( argv[1] ) ) };
 
-	sqlite3_result_int( context, best );
+	sqlite3_result_int( context, score );
 }
@@ -25,12 +25,15 @@
 #ifndef DOCSET_H
 #define DOCSET_H
 
+#include <util/sqliteconnectionpool.h>
 #include <util/sqlitedatabase.h>
 
 #include <QIcon>
 #include <QMap>
 #include <QMetaObject>
+#include <QMutex>
 #include <QUrl>
+#include <functional>
 #include <memory>
 
 namespace Zeal {
@@ -42,6 +45,7 @@ namespace Zeal {
 
 namespace Registry {
 
+class DocumentArchive;
 struct CancellationToken;
 struct SearchResult;
 
@@ -56,6 +60,9 @@ struct SearchResult;
  *   indexes all symbols (functions, classes, methods, etc.) for fast searching.
  * - **Resources**: Additional assets like CSS, JS, or images.
  *
+ * The documentation content is either a `Documents` directory or a single
+ * `Documents.zip`, read on demand through DocumentArchive.
+ *
  * \section interaction_with_kdevelop Interaction with KDevelop
  * If your plugin integrates with KDevelop, its role is likely to:
  *
@@ -68,7 +75,81 @@ struct SearchResult;
 class Docset
 {
 public:
-	explicit Docset( const QString& path );
+	/*!
+	 * \class SymbolCursor
+	 * \brief Pages through the symbols of one type in case-insensitive name order.
+	 *
+	 * The cursor remembers the last (name, rowid) it returned and asks SQLite only
+	 * for rows after it, using the (type, name) index. Every page costs the same no
+	 * matter how far into the type it is, unlike LIMIT/OFFSET or symbols(). A type
+	 * spread over several raw type strings costs one range per string.
+	 *
+	 * Cursors are cheap to copy and must not outlive their docset.
+	 */
+	class SymbolCursor
+	{
+	public:
+		/*!
+		 * \brief Fetches the next page of symbols.
+		 * \param count The maximum number of symbols to return.
+		 * \return Up to \a count symbols, with `type` set and `score` 0.
+		 */
+		QList<SearchResult> fetch( int count );
+
+		/*!
+		 * \brief Checks whether the last fetch() reached the end of the type.
+		 */
+		[[nodiscard]] bool atEnd() const;
+
+	private:
+		friend class Docset;
+		SymbolCursor( const Docset* docset, const QString& symbolType );
+
+		const Docset* m_docset;
+		QString	      m_symbolType;
+		QString	      m_lastName;	  /*!< Name of the last row returned. */
+		qint64	      m_lastRowId = -1;	  /*!< Rowid of the last row returned. */
+		bool	      m_atEnd	  = false;
+	};
+
+	/*!
+	 * \struct PageLocation
+	 * \brief Where a symbol is documented, as the index stores it.
+	 *
+	 * Many symbols share a page, so keeping the relative path and the anchor apart
+	 * lets callers store each page once and build the URL only when it is needed.
+	 */
+	struct PageLocation
+	{
+		QString path;			   /*!< Page, relative to documentPath(). */
+		QString fragment;		   /*!< Anchor on the page, may be empty. */
+		bool	decodedFragment = false;   /*!< An `//apple_ref` or `//dash_ref` anchor, set verbatim. */
+	};
+
+	/*!
+	 * \brief Cleans up a path and fragment read from the index.
+	 *
+	 * Splits off a fragment embedded in \a path when \a fragment is empty and removes
+	 * Dash's `<dash_entry_...>` placeholders.
+	 */
+	static PageLocation pageLocation( const QString& path, const QString& fragment = QString{} );
+
+	/*!
+	 * \brief Builds the URL of \a location in the docset documented at \a documentPath.
+	 */
+	static QUrl pageUrl( const QString& documentPath, const PageLocation& location );
+
+	/*!
+	 * \brief Opens the docset at \a path.
+	 *
+	 * \param path The path of the `.docset` directory.
+	 * \param profile SQLite performance settings for the index connections. Writes
+	 *        and immutability are only applied to the read-only query connections. The
+	 *        cache size is the docset's total, split between its connections. Query
+	 *        connections are opened on first use.
+	 */
+	explicit Docset( const QString&			     path,
+			 const Util::SQLiteDatabase::Profile& profile = Util::SQLiteDatabase::Profile{} );
 	~Docset();
 
 	Docset( const Docset& dc ) = delete;
@@ -87,8 +168,18 @@ public:
 	QString revision() const;
 
 	QString path() const;
+	/*!
+	 * \brief Returns the base of the docset's pages.
+	 *
+	 * A local directory, or a `zeal-archive://` URL for archived docsets. Use
+	 * pageUrl() rather than joining paths to it.
+	 */
 	QString documentPath() const;
 	QIcon	icon() const;
+	/*!
+	 * \brief Returns the file icon() was loaded from, empty if the docset has none.
+	 */
+	QString iconPath() const;
 	QIcon	symbolTypeIcon( const QString& symbolType ) const;
 	QUrl	indexFileUrl() const;
 
@@ -97,6 +188,21 @@ public:
 
 	const QMap<QString, QUrl>& symbols( const QString& symbolType ) const;
 
+	/*!
+	 * \brief Calls \a f with every symbol of \a symbolType, in name order.
+	 *
+	 * Unlike symbols(), nothing is kept, and no URL is built.
+	 */
+	void forEachSymbol( const QString&						       symbolType,
+			    const std::function<void( const QString& name, const PageLocation& location )>& f ) const;
+
+	/*!
+	 * \brief Returns a cursor at the start of \a symbolType.
+	 *
+	 * Unlike symbols(), nothing is loaded or cached up front.
+	 */
+	SymbolCursor symbolCursor( const QString& symbolType ) const;
+
 	QList<SearchResult> search( const QString& query, const CancellationToken& token ) const;
 	QList<SearchResult> relatedLinks( const QUrl& url ) const;
 
@@ -109,7 +215,9 @@ private:
 	void loadMetadata();
 	void countSymbols();
 	void loadSymbols( const QString& symbolType ) const;
-	void loadSymbols( const QString& symbolType, const QString& symbolString ) const;
+	void readSymbols( Util::SQLiteDatabase&							db,
+			  const QString&							symbolString,
+			  const std::function<void( const QString&, const PageLocation& )>& f ) const;
 	void createIndex();
 	QUrl createPageUrl( const QString& path, const QString& fragment = QString{} ) const;
 
@@ -124,13 +232,20 @@ private:
 	QString	     m_path;
 	QString	     m_documentPath;	// FIXME add to github master
 	QIcon	     m_icon;
+	QString	     m_iconPath;
+
+	std::shared_ptr<DocumentArchive> m_archive;    // Set when the documents are archived
 
-	QUrl m_indexFileUrl;
+	QUrl	m_indexFileUrl;
+	QString m_metadataIndexFilePath;    // From meta.json, relative to the documents
 
 	QMultiMap<QString, QString>			m_symbolStrings;
 	QMap<QString, int>				m_symbolCounts;
 	mutable QMap<QString, QMultiMap<QString, QUrl>> m_symbols;
+	mutable QMutex					m_symbolsMutex;	   // Guards m_symbols
 	std::unique_ptr<Util::SQLiteDatabase>		m_db = nullptr;
+	// Read-only connections for queries, so they can run concurrently
+	std::unique_ptr<Util::SQLiteConnectionPool> m_readers = nullptr;
 };
 
 }    // namespace Registry
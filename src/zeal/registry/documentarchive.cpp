@@ -0,0 +1,291 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "documentarchive.h"
+
+#include <KArchiveDirectory>
+#include <KArchiveFile>
+#include <KZip>
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtDebug>
+#include <climits>
+
+namespace Zeal { namespace Registry {
+
+namespace {
+constexpr qint64 DefaultCacheSize{ 32 * 1024 * 1024 };
+
+// Open archives by id, so URLs can find them without owning them
+QMutex						       registryMutex;
+QHash<QString, std::weak_ptr<DocumentArchive>> registry;
+
+// Inflated documents of all archives, keyed by their URL. The cost is in KiB,
+// QCache counts it in an int.
+QMutex			    cacheMutex;
+QCache<QString, QByteArray> cache{ static_cast<int>( DefaultCacheSize / 1024 ) };
+
+QString archiveId( const QString& archivePath )
+{
+	// A valid host name that stays the same for the same archive
+	return QString::fromLatin1( QCryptographicHash::hash( QFileInfo( archivePath ).absoluteFilePath().toUtf8(),
+							      QCryptographicHash::Sha1 )
+					    .toHex()
+					    .left( 16 ) );
+}
+}    // namespace
+
+DocumentArchive::DocumentArchive( const QString& archivePath )
+	: m_id{ archiveId( archivePath ) }
+	, m_archivePath{ QFileInfo( archivePath ).absoluteFilePath() }
+	, m_zip{ std::make_unique<KZip>( archivePath ) }
+{
+	if ( !m_zip->open( QIODevice::ReadOnly ) )
+	{
+		qWarning() << "Can't open document archive" << archivePath;
+		return;
+	}
+
+	m_root = m_zip->directory();
+
+	// Archives made by zipping the Documents directory itself have it as their only entry
+	const QStringList entries{ m_root->entries() };
+
+	if ( entries == QStringList{ QStringLiteral( "Documents" ) } && m_root->entry( entries.first() )->isDirectory() )
+	{
+		m_root = static_cast<const KArchiveDirectory*>( m_root->entry( entries.first() ) );
+	}
+}
+
+DocumentArchive::~DocumentArchive()
+{
+	const QMutexLocker locker{ &registryMutex };
+
+	// A newer instance may already have taken the id
+	if ( registry.value( m_id ).expired() ) { registry.remove( m_id ); }
+}
+
+QString DocumentArchive::fileName() { return QStringLiteral( "Documents.zip" ); }
+
+std::shared_ptr<DocumentArchive> DocumentArchive::open( const QString& archivePath )
+{
+	const QString id{ archiveId( archivePath ) };
+
+	{
+		const QMutexLocker locker{ &registryMutex };
+
+		if ( auto archive{ registry.value( id ).lock() } ) { return archive; }
+	}
+
+	// Read the central directory unlocked, a failed archive unregisters itself when destroyed
+	std::shared_ptr<DocumentArchive> archive{ new DocumentArchive{ archivePath } };
+
+	if ( !archive->m_root ) { return nullptr; }
+
+	const QMutexLocker locker{ &registryMutex };
+
+	// Another thread may have opened it meanwhile
+	if ( auto other{ registry.value( id ).lock() } ) { return other; }
+
+	registry.insert( id, archive );
+
+	return archive;
+}
+
+std::shared_ptr<DocumentArchive> DocumentArchive::find( const QUrl& url )
+{
+	if ( url.scheme() != QLatin1String( Scheme ) ) { return nullptr; }
+
+	const QMutexLocker locker{ &registryMutex };
+
+	return registry.value( url.host() ).lock();
+}
+
+bool DocumentArchive::isArchivePath( const QString& documentPath )
+{
+	return documentPath.startsWith( QLatin1String( Scheme ) + QLatin1String( "://" ) );
+}
+
+void DocumentArchive::setCacheSize( qint64 bytes )
+{
+	const QMutexLocker locker{ &cacheMutex };
+
+	cache.setMaxCost( static_cast<int>( qBound( 0LL, bytes / 1024, static_cast<qint64>( INT_MAX ) ) ) );
+}
+
+QString DocumentArchive::documentPath() const
+{
+	return QLatin1String( Scheme ) + QLatin1String( "://" ) + m_id;
+}
+
+bool DocumentArchive::contains( const QString& path ) const
+{
+	const QMutexLocker	locker{ &m_mutex };
+	const KArchiveEntry* entry{ m_root->entry( QDir::cleanPath( path ) ) };
+
+	return entry && entry->isFile();
+}
+
+QByteArray DocumentArchive::read( const QString& path ) const
+{
+	const QString key{ documentPath() + QLatin1Char( '/' ) + QDir::cleanPath( path ) };
+
+	{
+		const QMutexLocker locker{ &cacheMutex };
+
+		if ( const QByteArray* data{ cache.object( key ) } ) { return *data; }
+	}
+
+	const QByteArray data{ inflate( path ) };
+
+	if ( data.isEmpty() ) { return {}; }
+
+	const QMutexLocker locker{ &cacheMutex };
+
+	// Documents bigger than the whole cache are served without being kept
+	cache.insert( key, new QByteArray{ data }, qMax( 1, static_cast<int>( data.size() / 1024 ) ) );
+
+	return data;
+}
+
+QByteArray DocumentArchive::inflate( const QString& path ) const
+{
+	const QMutexLocker	locker{ &m_mutex };
+	const KArchiveEntry* entry{ m_root->entry( QDir::cleanPath( path ) ) };
+
+	if ( !entry || !entry->isFile() ) { return {}; }
+
+	return static_cast<const KArchiveFile*>( entry )->data();
+}
+
+void DocumentArchive::forEachDocument(
+	const std::function<void( const QString& path, qint64 modified, qint64 size )>& f ) const
+{
+	// The directory tree is built when the archive is opened, listing it reads nothing
+	const std::function<void( const KArchiveDirectory*, const QString& )> walk{
+		[&]( const KArchiveDirectory* dir, const QString& prefix ) {
+			for ( const QString& name : dir->entries() )
+			{
+				const KArchiveEntry* entry{ dir->entry( name ) };
+
+				if ( entry->isDirectory() )
+				{
+					walk( static_cast<const KArchiveDirectory*>( entry ), prefix + name + QLatin1Char( '/' ) );
+				}
+				else
+				{
+					f( prefix + name, entry->date().toMSecsSinceEpoch(),
+					   static_cast<const KArchiveFile*>( entry )->size() );
+				}
+			}
+		} };
+
+	walk( m_root, QString{} );
+}
+
+QByteArray DocumentArchive::read( const QUrl& url )
+{
+	const std::shared_ptr<DocumentArchive> archive{ find( url ) };
+
+	if ( !archive ) { return {}; }
+
+	// Paths are relative to the archive root
+	return archive->read( url.path( QUrl::FullyDecoded ).mid( 1 ) );
+}
+
+QUrl DocumentArchive::localUrl( const QUrl& url )
+{
+	const std::shared_ptr<DocumentArchive> archive{ find( url ) };
+
+	if ( !archive ) { return {}; }
+
+	const QString dir{ archive->extract() };
+
+	if ( dir.isEmpty() ) { return {}; }
+
+	QUrl local{ QUrl::fromLocalFile( dir + url.path( QUrl::FullyDecoded ) ) };
+	local.setFragment( url.fragment( QUrl::FullyDecoded ), QUrl::DecodedMode );
+
+	return local;
+}
+
+QString DocumentArchive::extract() const
+{
+	const QString cacheDir{ QStandardPaths::writableLocation( QStandardPaths::CacheLocation )
+				+ QStringLiteral( "/archives" ) };
+	const QString dir{ cacheDir + QLatin1Char( '/' ) + m_id };
+	const QString stamp{ QString::number( QFileInfo( m_archivePath ).lastModified().toMSecsSinceEpoch() ) };
+	const QString stampPath{ dir + QStringLiteral( "/.archive-stamp" ) };
+
+	const auto isCurrent = [&] {
+		QFile stampFile{ stampPath };
+		return stampFile.open( QIODevice::ReadOnly ) && QString::fromLatin1( stampFile.readAll() ) == stamp;
+	};
+
+	// Held while unpacking, so views opened meanwhile wait for a complete copy
+	const QMutexLocker locker{ &m_mutex };
+
+	if ( isCurrent() ) { return dir; }
+
+	// Unpacked beside the copy and swapped in, so another KDevelop never sees half of it
+	if ( !QDir{}.mkpath( cacheDir ) ) { return {}; }
+
+	QTemporaryDir part{ cacheDir + QLatin1Char( '/' ) + m_id + QStringLiteral( "-XXXXXX" ) };
+
+	if ( !part.isValid() ) { return {}; }
+
+	m_root->copyTo( part.path() );
+
+	QSaveFile stampFile{ part.path() + QStringLiteral( "/.archive-stamp" ) };
+
+	if ( !stampFile.open( QIODevice::WriteOnly ) || stampFile.write( stamp.toLatin1() ) < 0 || !stampFile.commit() )
+	{
+		qWarning() << "Can't unpack document archive" << m_archivePath << "to" << cacheDir;
+		return {};
+	}
+
+	QDir{ dir }.removeRecursively();
+
+	if ( !QDir{}.rename( part.path(), dir ) )
+	{
+		// Another KDevelop may have put its copy there first
+		if ( isCurrent() ) { return dir; }
+
+		qWarning() << "Can't move the unpacked document archive to" << dir;
+		return {};
+	}
+
+	part.setAutoRemove( false );
+
+	return dir;
+}
+
+}}    // namespace Zeal::Registry
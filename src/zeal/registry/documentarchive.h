@@ -0,0 +1,154 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef ZEAL_REGISTRY_DOCUMENTARCHIVE_H
+#define ZEAL_REGISTRY_DOCUMENTARCHIVE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+#include <functional>
+#include <memory>
+
+class KArchiveDirectory;
+class KZip;
+
+namespace Zeal { namespace Registry {
+
+/*!
+ * \brief A docset's documents stored as one compressed archive.
+ *
+ * Instead of a `Contents/Resources/Documents` directory holding thousands of
+ * small pages, a docset may ship `Contents/Resources/Documents.zip`. Zip
+ * archives compress every member on its own and end with a central directory,
+ * so a single page is found and inflated without touching the rest.
+ *
+ * Pages are addressed with `zeal-archive://<id>/<path>` URLs, where `<id>`
+ * identifies the open archive. Inflated pages are kept in a memory cache shared
+ * by all archives and bounded by setCacheSize().
+ *
+ * These URLs are for the plugin's own reads (symbols, snippets, full-text search).
+ * Documentation views can't load them: a plugin comes too late to register a URL
+ * scheme with QtWebEngine, and pages need their stylesheets and images beside
+ * them. Views load the local copy from localUrl() instead.
+ *
+ * All members can be used from any thread.
+ */
+class DocumentArchive
+{
+public:
+	/*!
+	 * \brief The URL scheme of archived pages.
+	 */
+	static constexpr char Scheme[] = "zeal-archive";
+
+	/*!
+	 * \brief Destroys the archive, closing its file.
+	 */
+	~DocumentArchive();
+
+	/*!
+	 * \brief Returns the file name of a docset's document archive.
+	 */
+	static QString fileName();
+
+	/*!
+	 * \brief Opens the archive at \a archivePath, or shares the one already open.
+	 * \return The archive, null if it can't be read.
+	 */
+	static std::shared_ptr<DocumentArchive> open( const QString& archivePath );
+
+	/*!
+	 * \brief Returns the open archive serving \a url, null if there is none.
+	 */
+	static std::shared_ptr<DocumentArchive> find( const QUrl& url );
+
+	/*!
+	 * \brief Tells if \a documentPath, as returned by Docset::documentPath(), is an archive.
+	 */
+	static bool isArchivePath( const QString& documentPath );
+
+	/*!
+	 * \brief Bounds the memory of the inflated pages of all archives, in bytes.
+	 */
+	static void setCacheSize( qint64 bytes );
+
+	/*!
+	 * \brief Returns the base URL of the archived documents, as a string.
+	 */
+	QString documentPath() const;
+
+	/*!
+	 * \brief Tells if the archive holds the document at \a path.
+	 */
+	bool contains( const QString& path ) const;
+
+	/*!
+	 * \brief Returns the inflated document at \a path, empty if there is none.
+	 */
+	QByteArray read( const QString& path ) const;
+
+	/*!
+	 * \brief Like read(), but bypasses the cache, for reading many documents once.
+	 */
+	QByteArray inflate( const QString& path ) const;
+
+	/*!
+	 * \brief Calls \a f with the path, modification time (ms since epoch) and size of every document.
+	 */
+	void forEachDocument( const std::function<void( const QString& path, qint64 modified, qint64 size )>& f ) const;
+
+	/*!
+	 * \brief Returns the document \a url points to, empty if there is none.
+	 */
+	static QByteArray read( const QUrl& url );
+
+	/*!
+	 * \brief Returns a `file://` URL of the page \a url points to, for documentation views.
+	 *
+	 * The first call for an archive unpacks all of it into the user's cache directory,
+	 * which blocks for a while on big docsets. The copy is kept until the archive changes.
+	 *
+	 * \return The local URL, with the fragment of \a url, invalid if unpacking failed.
+	 */
+	static QUrl localUrl( const QUrl& url );
+
+private:
+	explicit DocumentArchive( const QString& archivePath );
+
+	/*!
+	 * \brief Unpacks the archive unless an up-to-date copy exists.
+	 * \return The directory of the copy, empty on failure.
+	 */
+	QString extract() const;
+
+	QString			  m_id;
+	QString			  m_archivePath;
+	std::unique_ptr<KZip>	  m_zip;
+	const KArchiveDirectory*  m_root = nullptr;    /*!< Where document paths start. */
+	mutable QMutex		  m_mutex;	       /*!< KZip reads through one device. */
+};
+
+}}    // namespace Zeal::Registry
+
+#endif	  // ZEAL_REGISTRY_DOCUMENTARCHIVE_H
@@ -0,0 +1,273 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "searchscore.h"
+
+#include <QVarLengthArray>
+#include <QtGlobal>
+
+namespace Zeal { namespace Registry { namespace SearchScore {
+
+void foldNeedle( const unsigned char* in, int len, unsigned char* out )
+{
+	for ( int i = 0; i < len; ++i )
+	{
+		unsigned char c = in[i];
+		if ( c >= 'A' && c <= 'Z' ) { c += 32; }
+		out[i] = c;
+	}
+
+	out[len] = 0;
+}
+
+void foldHaystack( const unsigned char* in, int len, unsigned char* out )
+{
+	for ( int i = 0; i < len; ++i )
+	{
+		unsigned char c = in[i];
+
+		if ( ( i > 0 && in[i - 1] == ':' && c == ':' )	  // C++ (::)
+		     || c == '/' || c == '_' || c == ' ' )	  // Go, some Guides
+		{
+			out[i] = '.';
+		}
+		else
+		{
+			if ( c >= 'A' && c <= 'Z' ) { c += 32; }
+
+			out[i] = c;
+		}
+	}
+
+	out[len] = 0;
+}
+
+// ported from DevDocs' searcher.coffee:
+// (https://github.com/Thibaut/devdocs/blob/50f583246d5fbd92be7b71a50bfa56cf4e239c14/assets/javascripts/app/searcher.coffee#L91)
+void matchFuzzy( int nLen, const unsigned char* needle, int hLen, const unsigned char* haystack, int* start, int* len )
+{
+	int j	   = 0;
+	int groups = 0;
+
+	for ( int i = 0; i < nLen; ++i )
+	{
+		bool found    = false;
+		bool first    = true;
+		int  distance = 0;
+
+		while ( j < hLen )
+		{
+			if ( needle[i] == haystack[j++] )
+			{
+				if ( *start == -1 )
+					*start = j - 1;	   // first matched char
+
+				*len  = j - *start;
+				found = true;
+				break;	  // continue the outer loop
+			}
+			else
+			{
+				// optimizations to reduce returned number of results
+				// (search was returning too many irrelevant results with large docsets)
+				if ( first )
+				{
+					++groups;
+
+					if ( groups > 3 )    // optimization #1: too many mismatches
+					{
+						break;
+					}
+					first = false;
+				}
+
+				if ( i != 0 )
+				{
+					++distance;
+
+					if ( distance > 8 )    // optimization #2: too large distance between found chars
+					{
+						break;
+					}
+				}
+			}
+		}
+
+		if ( !found )
+		{
+			// end of haystack, char not found
+			*start = -1;
+			return;
+		}
+	}
+}
+
+int scoreExact( int matchIndex, int matchLen, const unsigned char* value, int valueLen )
+{
+	int		    score = 100;
+	const unsigned char DOT	  = '.';
+	// Remove one point for each unmatched character.
+	score -= ( valueLen - matchLen );
+
+	if ( matchIndex > 0 )
+	{
+		if ( value[matchIndex - 1] == DOT )
+		{
+			// If the character preceding the query is a dot, assign the
+			// same score as if the query was found at the beginning of the
+			// string, minus one.
+			score += ( matchIndex - 1 );
+		}
+		else if ( matchLen == 1 )
+		{
+			// Don't match a single-character query unless it's found at the
+			// beginning of the string or is preceded by a dot.
+			return 0;
+		}
+		else
+		{
+			// (1) Remove one point for each unmatched character up to
+			//     the nearest preceding dot or the beginning of the
+			//     string.
+			// (2) Remove one point for each unmatched character
+			//     following the query.
+			int i = matchIndex - 2;
+
+			while ( i >= 0 && value[i] != DOT ) --i;
+
+			score -= ( matchIndex - i ) +			  // (1)
+				 ( valueLen - matchLen - matchIndex );	  // (2)
+		}
+
+		// Remove one point for each dot preceding the query, except for the
+		// one immediately before the query.
+		int separators = 0;
+		int index      = matchIndex - 2;
+
+		while ( index >= 0 )
+		{
+			if ( value[index] == DOT ) ++separators;
+
+			--index;
+		}
+
+		score -= separators;
+	}
+
+	// Remove five points for each dot following the query.
+	int separators = 0;
+	int index      = valueLen - matchLen - matchIndex - 1;
+
+	while ( index >= 0 )
+	{
+		if ( value[matchIndex + matchLen + index] == DOT ) { ++separators; }
+
+		--index;
+	}
+
+	score -= separators * 5;
+
+	return qMax( 1, score );
+}
+
+int scoreFuzzy( int matchIndex, int matchLen, const unsigned char* value )
+{
+	if ( matchIndex == 0 || value[matchIndex - 1] == '.' )
+	{
+		// score between 66..99, if the match follows a dot, or starts the string
+		return qMax( 66, 100 - matchLen );
+	}
+	else
+	{
+		if ( value[matchIndex + matchLen] == 0 )
+		{
+			// score between 33..66, if the match is at the end of the string
+			return qMax( 33, 67 - matchLen );
+		}
+		else
+		{
+			// score between 1..33 otherwise (match in the middle of the string)
+			return qMax( 1, 34 - matchLen );
+		}
+	}
+}
+
+int score( const unsigned char* needleOrig, int needleLen, const unsigned char* haystackOrig, int haystackLen )
+{
+	// Called once per row, so short names must not touch the heap
+	QVarLengthArray<unsigned char, 256> needle( needleLen + 1 );
+	QVarLengthArray<unsigned char, 256> haystack( haystackLen + 1 );
+
+	foldNeedle( needleOrig, needleLen, needle.data() );
+	foldHaystack( haystackOrig, haystackLen, haystack.data() );
+
+	int best   = 0;
+	int match1 = -1;
+	int match1Len;
+
+	matchFuzzy( needleLen, needle.data(), haystackLen, haystack.data(), &match1, &match1Len );
+
+	if ( match1 == -1 )    // no match
+	{
+		return 0;
+	}
+	else if ( needleLen == match1Len )    // exact match
+	{
+		best = scoreExact( match1, match1Len, haystack.data(), haystackLen );
+	}
+	else
+	{
+		best = scoreFuzzy( match1, match1Len, haystack.data() );
+
+		int indexOfLastDot = -1;
+
+		for ( int i = 0; haystack[i] != 0; ++i )
+		{
+			if ( haystack[i] == '.' ) indexOfLastDot = i;
+		}
+
+		if ( indexOfLastDot != -1 )
+		{
+			int match2 = -1, match2Len;
+			matchFuzzy( needleLen,
+				    needle.data(),
+				    haystackLen - ( indexOfLastDot + 1 ),
+				    haystack.data() + indexOfLastDot + 1,
+				    &match2,
+				    &match2Len );
+
+			if ( match2 != -1 )
+			{
+				best = qMax( best,
+					     scoreFuzzy( match2,
+							 match2Len,
+							 haystack.data() + indexOfLastDot + 1 ) );
+			}
+		}
+	}
+
+	return best;
+}
+
+}    // namespace SearchScore
+}    // namespace Registry
+}    // namespace Zeal
@@ -0,0 +1,85 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef ZEAL_REGISTRY_SEARCHSCORE_H
+#define ZEAL_REGISTRY_SEARCHSCORE_H
+
+namespace Zeal { namespace Registry {
+
+/*!
+ * \brief The relevance rules used to rank symbols against a query.
+ *
+ * Ported from DevDocs' searcher. SQLite calls score() for every row through the
+ * `zealScore` function, and the token table uses scoreExact() to rank fallback
+ * matches, so both rank the same way.
+ *
+ * All functions work on folded UTF-8: queries are lowercased with foldNeedle() and
+ * symbol names additionally get their separators (`::`, `/`, `_`, space) turned into
+ * dots with foldHaystack().
+ */
+namespace SearchScore {
+
+/*!
+ * \brief Lowercases the ASCII letters of \a len bytes of \a in into \a out.
+ *
+ * \a out must have room for \a len + 1 bytes and is NUL-terminated.
+ */
+void foldNeedle( const unsigned char* in, int len, unsigned char* out );
+
+/*!
+ * \brief Like foldNeedle(), but also turns separators into dots.
+ */
+void foldHaystack( const unsigned char* in, int len, unsigned char* out );
+
+/*!
+ * \brief Finds the characters of \a needle in order in \a haystack.
+ * \param start Set to the index of the first matched character, left at -1 if there is no match.
+ * \param len Set to the length of the matched span.
+ */
+void matchFuzzy( int nLen, const unsigned char* needle, int hLen, const unsigned char* haystack, int* start, int* len );
+
+/*!
+ * \brief Scores a contiguous match of \a matchLen bytes at \a matchIndex in \a value.
+ * \return 1..100, or 0 for a single character that does not start a component.
+ */
+int scoreExact( int matchIndex, int matchLen, const unsigned char* value, int valueLen );
+
+/*!
+ * \brief Scores a fuzzy match spanning \a matchLen bytes at \a matchIndex in \a value.
+ * \return 1..99.
+ */
+int scoreFuzzy( int matchIndex, int matchLen, const unsigned char* value );
+
+/*!
+ * \brief Scores a symbol name against a query.
+ *
+ * Both are taken as they come from the docset and the user and are folded here.
+ *
+ * \return The relevance, 0 if \a haystack does not match.
+ */
+int score( const unsigned char* needle, int needleLen, const unsigned char* haystack, int haystackLen );
+
+}    // namespace SearchScore
+}    // namespace Registry
+}    // namespace Zeal
+
+#endif	  // ZEAL_REGISTRY_SEARCHSCORE_H
@@ -24,15 +24,206 @@
 
 #include <QFile>
 #include <QXmlStreamReader>
+#include <QtEndian>
+#include <memory>
 
 using namespace Zeal::Util;
 
+namespace {
+constexpr char		BinaryMagic[] = "bplist00";
+constexpr qint64	BinaryMagicSize{ 8 };
+constexpr qint64	TrailerSize{ 32 };
+
+/*!
+ * \brief Reads a big-endian unsigned integer of \a size bytes, as binary plists store them.
+ */
+quint64 readBigEndian( const uchar* data, int size )
+{
+	quint64 value{ 0 };
+
+	for ( int i = 0; i < size; ++i ) { value = ( value << 8 ) | data[i]; }
+
+	return value;
+}
+
+/*!
+ * \brief The objects of a binary plist, with every access checked against the file's bounds.
+ */
+class BinaryObjects
+{
+public:
+	BinaryObjects( const uchar* data, qint64 size )
+		: m_data{ data }
+		, m_size{ size }
+	{}
+
+	/*!
+	 * \brief Reads the trailer, false if it doesn't describe a sane offset table.
+	 */
+	bool readTrailer()
+	{
+		if ( m_size < BinaryMagicSize + TrailerSize ) { return false; }
+
+		const uchar* trailer{ m_data + m_size - TrailerSize };
+
+		m_offsetSize	  = trailer[6];
+		m_refSize	  = trailer[7];
+		m_objectCount	  = readBigEndian( trailer + 8, 8 );
+		m_topObject	  = readBigEndian( trailer + 16, 8 );
+		m_offsetTable	  = readBigEndian( trailer + 24, 8 );
+
+		return m_offsetSize >= 1 && m_offsetSize <= 8 && m_refSize >= 1 && m_refSize <= 8
+		       && m_topObject < m_objectCount && m_offsetTable >= static_cast<quint64>( BinaryMagicSize )
+		       && m_objectCount <= static_cast<quint64>( m_size ) / m_offsetSize
+		       && m_offsetTable + m_objectCount * m_offsetSize <= static_cast<quint64>( m_size - TrailerSize );
+	}
+
+	quint64 objectCount() const { return m_objectCount; }
+	quint64 topObject() const { return m_topObject; }
+
+	/*!
+	 * \brief Returns where object \a ref starts, -1 if it's out of the file.
+	 */
+	qint64 offsetOf( quint64 ref ) const
+	{
+		if ( ref >= m_objectCount ) { return -1; }
+
+		const quint64 offset{ readBigEndian( m_data + m_offsetTable + ref * m_offsetSize, m_offsetSize ) };
+
+		return offset >= static_cast<quint64>( BinaryMagicSize ) && offset < m_offsetTable
+			       ? static_cast<qint64>( offset )
+			       : -1;
+	}
+
+	/*!
+	 * \brief Reads the marker of object \a ref and its length, which may follow as an integer object.
+	 * \param payload Set to where the object's content starts.
+	 * \return The marker, 0xff if the object is unreadable.
+	 */
+	uchar header( quint64 ref, quint64& length, qint64& payload ) const
+	{
+		const qint64 offset{ offsetOf( ref ) };
+
+		if ( offset < 0 ) { return 0xff; }
+
+		const uchar marker{ m_data[offset] };
+		length	= marker & 0x0f;
+		payload = offset + 1;
+
+		if ( length == 0x0f && ( marker & 0xf0 ) != 0x00 && ( marker & 0xf0 ) != 0x10 )
+		{
+			// Long lengths are stored as an integer object right after the marker
+			if ( payload >= static_cast<qint64>( m_offsetTable ) || ( m_data[payload] & 0xf0 ) != 0x10 ) { return 0xff; }
+
+			const int size{ 1 << ( m_data[payload] & 0x0f ) };
+
+			if ( size > 8 || payload + 1 + size > static_cast<qint64>( m_offsetTable ) ) { return 0xff; }
+
+			length = readBigEndian( m_data + payload + 1, size );
+			payload += 1 + size;
+		}
+
+		return marker;
+	}
+
+	/*!
+	 * \brief Reads reference \a index of the container at \a payload.
+	 */
+	bool ref( qint64 payload, quint64 index, quint64& ref ) const
+	{
+		const quint64 at{ payload + index * m_refSize };
+
+		if ( at + m_refSize > m_offsetTable ) { return false; }
+
+		ref = readBigEndian( m_data + at, m_refSize );
+		return true;
+	}
+
+	/*!
+	 * \brief Returns object \a ref as a string, null if it isn't one.
+	 */
+	QString string( quint64 ref ) const
+	{
+		quint64	     length{ 0 };
+		qint64	     payload{ 0 };
+		const uchar  marker{ header( ref, length, payload ) };
+		const quint64 end{ m_offsetTable };
+
+		switch ( marker & 0xf0 )
+		{
+		case 0x50:    // ASCII
+			if ( length > end - payload ) { return {}; }
+
+			return QString::fromLatin1( reinterpret_cast<const char*>( m_data + payload ),
+						    static_cast<int>( length ) );
+
+		case 0x60:    // UTF-16, big-endian
+		{
+			if ( length > ( end - payload ) / 2 ) { return {}; }
+
+			QString text( static_cast<int>( length ), Qt::Uninitialized );
+
+			for ( quint64 i = 0; i < length; ++i )
+			{
+				text[static_cast<int>( i )] = QChar( qFromBigEndian<quint16>( m_data + payload + i * 2 ) );
+			}
+
+			return text;
+		}
+
+		default: return {};
+		}
+	}
+
+	/*!
+	 * \brief Returns object \a ref as a value Plist keeps, invalid for other types.
+	 */
+	QVariant value( quint64 ref ) const
+	{
+		quint64	    length{ 0 };
+		qint64	    payload{ 0 };
+		const uchar marker{ header( ref, length, payload ) };
+
+		switch ( marker & 0xf0 )
+		{
+		case 0x00:
+			if ( marker == 0x08 ) { return false; }
+			if ( marker == 0x09 ) { return true; }
+			return {};
+
+		case 0x10:
+		{
+			const int size{ 1 << ( marker & 0x0f ) };
+
+			if ( size > 8 || payload + size > static_cast<qint64>( m_offsetTable ) ) { return {}; }
+
+			return static_cast<qint64>( readBigEndian( m_data + payload, size ) );
+		}
+
+		case 0x50:
+		case 0x60: return string( ref );
+
+		default: return {};
+		}
+	}
+
+private:
+	const uchar* m_data;
+	qint64	     m_size;
+	int	     m_offsetSize = 0;
+	int	     m_refSize	  = 0;
+	quint64	     m_objectCount = 0;
+	quint64	     m_topObject   = 0;
+	quint64	     m_offsetTable = 0;
+};
+}    // namespace
+
 Plist::Plist()
 	: QHash<QString, QVariant>{}
 	, m_hasError{ false }	 // Initialize the base QHash and error state
 {}
 
-bool Plist::read( const QString& fileName )
+bool Plist::read( const QString& fileName, const QStringList& keys )
 {
 	// Open the Plist file for reading
 	const std::unique_ptr<QFile> file{ std::make_unique<QFile>( fileName ) };
@@ -45,11 +236,39 @@ bool Plist::read( const QString& fileName )
 		return false;
 	}
 
+	// Mapped rather than read, the parsers usually stop long before the end
+	const qint64 size{ file->size() };
+	const uchar* data{ size > 0 ? file->map( 0, size ) : nullptr };
+
+	if ( !data )
+	{
+		m_hasError = true;
+		return false;
+	}
+
+	if ( size >= BinaryMagicSize && qstrncmp( reinterpret_cast<const char*>( data ), BinaryMagic, BinaryMagicSize ) == 0 )
+	{
+		m_hasError = !readBinary( data, size, keys );
+	}
+	else
+	{
+		m_hasError = !readXml( QByteArray::fromRawData( reinterpret_cast<const char*>( data ), static_cast<int>( size ) ),
+				       keys );
+	}
+
+	// Return the error state
+	return !m_hasError;
+}
+
+bool Plist::readXml( const QByteArray& data, const QStringList& keys )
+{
 	// Set up the XML reader
-	QXmlStreamReader xml( file.get() );
+	QXmlStreamReader xml( data );
+
+	int found{ 0 };
 
 	// Read the XML file
-	while ( !xml.atEnd() )
+	while ( !xml.atEnd() && ( keys.isEmpty() || found < keys.size() ) )
 	{
 		const QXmlStreamReader::TokenType token = xml.readNext();
 
@@ -71,6 +290,9 @@ bool Plist::read( const QString& fileName )
 		// Ensure the next token is a StartElement
 		if ( xml.tokenType() != QXmlStreamReader::StartElement ) continue;
 
+		// Don't convert values nobody asked for
+		if ( !keys.isEmpty() && !keys.contains( key ) ) continue;
+
 		QVariant value;
 
 		// Determine the type of the value and read it
@@ -83,12 +305,53 @@ bool Plist::read( const QString& fileName )
 		else
 			continue;    // Skip unknown or unsupported types
 
+		if ( !contains( key ) ) { ++found; }
+
 		// Insert the key-value pair into the hash
 		insert( key, value );
 	}
 
-	// Return the error state
-	return !m_hasError;
+	// Like before, a damaged document still gives what was read up to the damage
+	return !xml.hasError() || !isEmpty();
+}
+
+bool Plist::readBinary( const uchar* data, qint64 size, const QStringList& keys )
+{
+	BinaryObjects objects{ data, size };
+
+	if ( !objects.readTrailer() ) { return false; }
+
+	quint64	    count{ 0 };
+	qint64	    payload{ 0 };
+	const uchar marker{ objects.header( objects.topObject(), count, payload ) };
+
+	// Docset plists are a dictionary at the top
+	if ( ( marker & 0xf0 ) != 0xd0 || count > objects.objectCount() ) { return false; }
+
+	int found{ 0 };
+
+	// Keys come first, then the values in the same order
+	for ( quint64 i = 0; i < count && ( keys.isEmpty() || found < keys.size() ); ++i )
+	{
+		quint64 keyRef{ 0 };
+		quint64 valueRef{ 0 };
+
+		if ( !objects.ref( payload, i, keyRef ) || !objects.ref( payload, count + i, valueRef ) ) { return false; }
+
+		const QString key{ objects.string( keyRef ) };
+
+		if ( key.isNull() || ( !keys.isEmpty() && !keys.contains( key ) ) ) { continue; }
+
+		const QVariant value{ objects.value( valueRef ) };
+
+		if ( !value.isValid() ) { continue; }
+
+		if ( !contains( key ) ) { ++found; }
+
+		insert( key, value );
+	}
+
+	return true;
 }
 
 bool Plist::hasError() const { return m_hasError; }
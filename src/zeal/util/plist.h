@@ -24,6 +24,7 @@
 #define PLIST_H
 
 #include <QHash>
+#include <QStringList>
 #include <QVariant>
 
 namespace Zeal { namespace Util {
@@ -34,6 +35,10 @@ namespace Zeal { namespace Util {
  *
  * This class extends QHash<QString, QVariant> to provide functionality
  * for reading and storing data from Plist files (used in macOS/iOS for structured data storage).
+ *
+ * Both XML and binary (`bplist00`) property lists are read, from a memory mapping of
+ * the file. Only string, boolean and integer values of the top-level dictionary are
+ * kept.
  */
 class Plist: public QHash<QString, QVariant>
 {
@@ -44,9 +49,11 @@ public:
 	 * \brief Reads a Plist file and populates the hash with its key-value pairs.
 	 *
 	 * \param fileName The path to the Plist file to read.
+	 * \param keys The keys the caller needs. Reading stops once all of them are found,
+	 *        an empty list reads every key.
 	 * \return True if the file was successfully read, false otherwise.
 	 */
-	bool read( const QString& fileName );
+	bool read( const QString& fileName, const QStringList& keys = {} );
 
 	/*!
 	 * \brief Checks if an error occurred during the last read operation.
@@ -56,6 +63,16 @@ public:
 	[[nodiscard]] bool hasError() const;
 
 private:
+	/*!
+	 * \brief Reads an XML property list from \a data.
+	 */
+	bool readXml( const QByteArray& data, const QStringList& keys );
+
+	/*!
+	 * \brief Reads a binary property list from \a size bytes at \a data.
+	 */
+	bool readBinary( const uchar* data, qint64 size, const QStringList& keys );
+
 	bool m_hasError = false;
 };
 
@@ -0,0 +1,90 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "sqliteconnectionpool.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+using namespace Zeal::Util;
+
+SQLiteConnectionPool::Lease::Lease( SQLiteConnectionPool* pool, std::unique_ptr<SQLiteDatabase> db )
+	: m_pool{ pool }
+	, m_db{ std::move( db ) }
+{}
+
+SQLiteConnectionPool::Lease::~Lease()
+{
+	if ( m_pool && m_db ) { m_pool->release( std::move( m_db ) ); }
+}
+
+SQLiteConnectionPool::Lease::operator bool() const { return m_db && m_db->isOpen(); }
+
+SQLiteConnectionPool::SQLiteConnectionPool( const QString&		    path,
+					    const SQLiteDatabase::Profile& profile,
+					    int				    maxIdle,
+					    Initializer			    initializer )
+	: m_path{ path }
+	, m_profile{ profile }
+	, m_maxIdle{ qMax( 1, maxIdle ) }
+	, m_initializer{ std::move( initializer ) }
+{}
+
+SQLiteConnectionPool::~SQLiteConnectionPool() = default;
+
+SQLiteConnectionPool::Lease SQLiteConnectionPool::acquire()
+{
+	{
+		const QMutexLocker locker{ &m_mutex };
+
+		if ( !m_idle.empty() )
+		{
+			std::unique_ptr<SQLiteDatabase> db{ std::move( m_idle.back() ) };
+			m_idle.pop_back();
+			return Lease{ this, std::move( db ) };
+		}
+	}
+
+	// Opening a connection reads the schema, keep that outside the lock
+	auto db{ std::make_unique<SQLiteDatabase>(
+		m_path, SQLiteDatabase::OpenMode::ReadOnly, m_profile ) };
+
+	if ( !db->isOpen() )
+	{
+		qWarning( "SQL Error: %s", qPrintable( db->lastError() ) );
+		return {};
+	}
+
+	if ( m_initializer ) { m_initializer( *db ); }
+
+	return Lease{ this, std::move( db ) };
+}
+
+void SQLiteConnectionPool::release( std::unique_ptr<SQLiteDatabase> db )
+{
+	// Don't keep a half-read result set, or the next user inherits its read transaction
+	db->finalize();
+
+	const QMutexLocker locker{ &m_mutex };
+
+	if ( static_cast<int>( m_idle.size() ) < m_maxIdle ) { m_idle.push_back( std::move( db ) ); }
+}
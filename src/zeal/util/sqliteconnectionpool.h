@@ -0,0 +1,131 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef ZEAL_UTIL_SQLITECONNECTIONPOOL_H
+#define ZEAL_UTIL_SQLITECONNECTIONPOOL_H
+
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "sqlitedatabase.h"
+
+namespace Zeal { namespace Util {
+
+/*!
+ * \class SQLiteConnectionPool
+ * \brief Hands out read-only connections to one SQLite database, one per task.
+ *
+ * Every connection is opened with SQLiteDatabase::OpenMode::ReadOnly, so it has its own
+ * statement cache and no connection mutex. A connection is owned by exactly one Lease
+ * at a time, which lets several queries on the same database run in parallel instead
+ * of serializing on a shared statement.
+ *
+ * Released connections are kept for reuse up to the idle limit and closed beyond it.
+ * The pool must outlive all of its leases.
+ */
+class SQLiteConnectionPool
+{
+public:
+	/*!
+	 * \brief Called once for every newly opened connection, e.g. to register functions.
+	 */
+	using Initializer = std::function<void( SQLiteDatabase& )>;
+
+	/*!
+	 * \class Lease
+	 * \brief Exclusive use of a pooled connection, returned to the pool on destruction.
+	 */
+	class Lease
+	{
+	public:
+		Lease() = default;
+		Lease( SQLiteConnectionPool* pool, std::unique_ptr<SQLiteDatabase> db );
+		Lease( Lease&& other ) noexcept = default;
+		~Lease();
+
+		Lease( const Lease& )		 = delete;
+		Lease& operator=( const Lease& ) = delete;
+		Lease& operator=( Lease&& )	 = delete;
+
+		/*!
+		 * \brief Checks whether the lease holds an open connection.
+		 */
+		explicit operator bool() const;
+
+		SQLiteDatabase* operator->() const { return m_db.get(); }
+		SQLiteDatabase& operator*() const { return *m_db; }
+
+	private:
+		SQLiteConnectionPool*		m_pool = nullptr;
+		std::unique_ptr<SQLiteDatabase> m_db;
+	};
+
+	/*!
+	 * \brief Constructs a pool for the database at \a path.
+	 *
+	 * No connection is opened until the first call to acquire().
+	 *
+	 * \param path The file path to the SQLite database file.
+	 * \param profile The performance settings of every connection.
+	 * \param maxIdle The number of released connections kept open for reuse.
+	 * \param initializer Optional setup run on every new connection.
+	 */
+	SQLiteConnectionPool( const QString&		     path,
+			      const SQLiteDatabase::Profile& profile,
+			      int			     maxIdle,
+			      Initializer		     initializer = {} );
+	~SQLiteConnectionPool();
+
+	SQLiteConnectionPool( const SQLiteConnectionPool& )		   = delete;
+	SQLiteConnectionPool& operator=( const SQLiteConnectionPool& ) = delete;
+
+	/*!
+	 * \brief Takes an idle connection or opens a new one.
+	 *
+	 * This never blocks on other leases. Check the result, opening a new connection
+	 * can fail.
+	 *
+	 * \return A lease on the connection, empty if no connection could be opened.
+	 */
+	[[nodiscard]] Lease acquire();
+
+private:
+	/*!
+	 * \brief Puts a connection back into the idle list, or closes it if that is full.
+	 */
+	void release( std::unique_ptr<SQLiteDatabase> db );
+
+	const QString			m_path;
+	const SQLiteDatabase::Profile	m_profile;
+	const int			m_maxIdle;
+	const Initializer m_initializer;
+
+	QMutex					     m_mutex;
+	std::vector<std::unique_ptr<SQLiteDatabase>> m_idle; /*!< Guarded by m_mutex. */
+};
+
+}}    // namespace Zeal::Util
+
+#endif	  // ZEAL_UTIL_SQLITECONNECTIONPOOL_H
@@ -22,23 +22,54 @@
 
 #include "sqlitedatabase.h"
 
+#include <QUrl>
+
 #include "macros.hpp"
+#include "trace.h"
 
-Zeal::Util::SQLiteDatabase::SQLiteDatabase( const QString& path )
+Zeal::Util::SQLiteDatabase::SQLiteDatabase( const QString& path,
+					    OpenMode	   mode,
+					    const Profile& profile )
 	: m_db{ nullptr, SQLite3Deleter{} }
-	, m_stmt{ nullptr, SQLite3StmtDeleter{} }
+	, m_oneShotStmt{ nullptr, SQLite3StmtDeleter{} }
 {
 	if ( sqlite3_initialize() != SQLITE_OK ) return;    // Initialize SQLite library
 
-	sqlite3* raw_db{ m_db.get() };
-	if ( sqlite3_open16( path.constData(), &raw_db ) != SQLITE_OK )
+	sqlite3* raw_db{ nullptr };
+	int	 res{ SQLITE_OK };
+
+	if ( mode == OpenMode::ReadOnly )
 	{
-		updateLastError();    // Store the error message
-		close();	      // Ensure resources are cleaned up
+		// Readers are handed to one thread at a time, so the connection mutex
+		// would only add locking to every step.
+		// An immutable database skips all file locking and change detection, so
+		// it is only safe when nothing rewrites the docset while it is open.
+		QUrl uri{ QUrl::fromLocalFile( path ) };
+
+		if ( profile.immutable ) { uri.setQuery( QStringLiteral( "immutable=1" ) ); }
+
+		res = sqlite3_open_v2( uri.toEncoded().constData(),
+				       &raw_db,
+				       SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI,
+				       nullptr );
+		m_immutable = profile.immutable;
+	}
+	else { res = sqlite3_open16( path.constData(), &raw_db ); }
+
+	if ( res != SQLITE_OK )
+	{
+		// Store the error message before the handle goes away
+		if ( raw_db )
+		{
+			m_lastError = QString::fromUtf8( sqlite3_errmsg( raw_db ) );
+		}
+
 		sqlite3_close( raw_db );
+		return;
 	}
 
 	m_db.reset( raw_db );
+	applyProfile( profile );
 }
 
 Zeal::Util::SQLiteDatabase::~SQLiteDatabase()
@@ -63,7 +94,7 @@ QStringList Zeal::Util::SQLiteDatabase::tables()
 
 	if ( !sql.isEmpty() && execute( sql ) )
 	{
-		while ( next() ) { res.append( value( 0 ).toString() ); }
+		while ( next() ) { res.append( stringValue( 0 ) ); }
 	}
 
 	return res;
@@ -73,31 +104,28 @@ bool Zeal::Util::SQLiteDatabase::execute( const QString& queryStr )
 {
 	if ( !m_db ) return false;
 
-	if ( m_stmt ) { finalize(); }	 // Finalize any active statement
+	finalize();    // Finalize any active statement
 
 	m_lastError.clear();
 
+	const QByteArray sql{ queryStr.toUtf8() };
+
 	sqlite3_mutex_enter( sqlite3_db_mutex( m_db.get() ) );	  // Lock the database for thread safety
-	const void*   pzTail = nullptr;
-	sqlite3_stmt* raw{ m_stmt.get() };
-	const int     res{ sqlite3_prepare16_v2( m_db.get(),
-						 queryStr.constData(),
-						 ( queryStr.size() + 1 ) * sizeof( QChar ),
-						 &raw,
-						 &pzTail ) };
+	const char*   pzTail = nullptr;
+	sqlite3_stmt* raw{ nullptr };
+	const int     res{ sqlite3_prepare_v2(
+		    m_db.get(), sql.constData(), sql.size() + 1, &raw, &pzTail ) };
 
-	m_stmt.reset( raw );
+	m_oneShotStmt.reset( raw );
 	sqlite3_mutex_leave( sqlite3_db_mutex( m_db.get() ) );	  // Unlock the database
 
 	if ( res != SQLITE_OK )
 	{
 		updateLastError();    // Store the error
 		finalize();
-		sqlite3_finalize( raw );
 		return false;
 	}
-	else if ( pzTail
-		  && !QString( reinterpret_cast<const QChar*>( pzTail ) ).trimmed().isEmpty() )
+	else if ( pzTail && !QByteArray( pzTail ).trimmed().isEmpty() )
 	{
 		// Ensure no multiple statements are executed
 		updateLastError();
@@ -105,15 +133,91 @@ bool Zeal::Util::SQLiteDatabase::execute( const QString& queryStr )
 		return false;
 	}
 
+	m_stmt = m_oneShotStmt.get();
+	return true;
+}
+
+bool Zeal::Util::SQLiteDatabase::prepare( const QString& queryStr )
+{
+	if ( !m_db ) return false;
+
+	finalize();    // Release the previous statement, cached or not
+
+	m_lastError.clear();
+
+	const auto cached{ m_statementCache.find( queryStr ) };
+
+	if ( cached != m_statementCache.end() )
+	{
+		// Already compiled, only the bindings from the last run have to go
+		sqlite3_clear_bindings( cached->second.get() );
+		m_stmt = cached->second.get();
+		return true;
+	}
+
+	const QByteArray sql{ queryStr.toUtf8() };
+
+	sqlite3_mutex_enter( sqlite3_db_mutex( m_db.get() ) );	  // Lock the database for thread safety
+	const char*   pzTail = nullptr;
+	sqlite3_stmt* raw{ nullptr };
+	const int     res{ sqlite3_prepare_v3( m_db.get(),
+						 sql.constData(),
+						 sql.size() + 1,
+						 SQLITE_PREPARE_PERSISTENT,
+						 &raw,
+						 &pzTail ) };
+	StatementPtr  stmt{ raw };
+	sqlite3_mutex_leave( sqlite3_db_mutex( m_db.get() ) );	  // Unlock the database
+
+	if ( res != SQLITE_OK )
+	{
+		updateLastError();    // Store the error
+		return false;
+	}
+	else if ( !stmt || ( pzTail && !QByteArray( pzTail ).trimmed().isEmpty() ) )
+	{
+		// Empty queries and multiple statements can't be cached
+		updateLastError();
+		return false;
+	}
+
+	m_stmt = stmt.get();
+	m_statementCache.emplace( queryStr, std::move( stmt ) );
 	return true;
 }
 
+bool Zeal::Util::SQLiteDatabase::bindText( int index, const QString& value )
+{
+	if ( !m_stmt ) return false;
+
+	const QByteArray utf8{ value.toUtf8() };
+	return checkBind( sqlite3_bind_text(
+		m_stmt, index, utf8.constData(), utf8.size(), SQLITE_TRANSIENT ) );
+}
+
+bool Zeal::Util::SQLiteDatabase::bindInt64( int index, qint64 value )
+{
+	if ( !m_stmt ) return false;
+
+	return checkBind( sqlite3_bind_int64( m_stmt, index, value ) );
+}
+
+bool Zeal::Util::SQLiteDatabase::bindNull( int index )
+{
+	if ( !m_stmt ) return false;
+
+	return checkBind( sqlite3_bind_null( m_stmt, index ) );
+}
+
 bool Zeal::Util::SQLiteDatabase::next()
 {
 	if ( !m_stmt ) return false;
 
+	// Most steps hand out a ready row, only the slow ones are worth a span
+	ZEAL_TRACE_SPAN( "sqlite", "sqlite3_step", 50000 );
+
 	sqlite3_mutex_enter( sqlite3_db_mutex( m_db.get() ) );	  // Lock the database
-	const int res = sqlite3_step( m_stmt.get() );
+	const int res = sqlite3_step( m_stmt );
 	sqlite3_mutex_leave( sqlite3_db_mutex( m_db.get() ) );	  // Unlock the database
 
 	switch ( res )
@@ -134,36 +238,53 @@ QVariant Zeal::Util::SQLiteDatabase::value( int index ) const
 {
 	Q_ASSERT_X( index >= 0, "SQLiteDatabase::value", "Index must be non-negative." );
 
-	if ( index >= sqlite3_data_count( m_stmt.get() ) )
+	if ( index >= sqlite3_data_count( m_stmt ) )
 	{
 		return {};    // Invalid index
 	}
 
-	sqlite3_mutex_enter( sqlite3_db_mutex( m_db.get() ) );	  // Lock the database
-	const int type = sqlite3_column_type( m_stmt.get(), index );
-
-	QVariant ret;
-
-	switch ( type )
+	switch ( sqlite3_column_type( m_stmt, index ) )
 	{
-		case SQLITE_INTEGER:
-			ret = sqlite3_column_int64( m_stmt.get(), index );
-			break;
+		case SQLITE_INTEGER: return sqlite3_column_int64( m_stmt, index );
 
 		case SQLITE_NULL:
-			ret = QVariant{ QVariant::String };    // Represent NULL as empty string
-			break;
-
-		default:
-			ret = QString( reinterpret_cast<const QChar*>(
-					       sqlite3_column_text16( m_stmt.get(), index ) ),
-				       sqlite3_column_bytes16( m_stmt.get(), index )
-					       / sizeof( QChar ) );
-			break;
+			return QVariant{ QVariant::String };	// Represent NULL as empty string
+
+		default: return stringValue( index );
 	}
+}
 
-	sqlite3_mutex_leave( sqlite3_db_mutex( m_db.get() ) );	  // Unlock the database
-	return ret;
+bool Zeal::Util::SQLiteDatabase::isNull( int index ) const
+{
+	if ( index < 0 || index >= sqlite3_data_count( m_stmt ) ) { return true; }
+
+	return sqlite3_column_type( m_stmt, index ) == SQLITE_NULL;
+}
+
+qint64 Zeal::Util::SQLiteDatabase::int64Value( int index ) const
+{
+	if ( index < 0 || index >= sqlite3_data_count( m_stmt ) ) { return 0; }
+
+	return sqlite3_column_int64( m_stmt, index );
+}
+
+std::string_view Zeal::Util::SQLiteDatabase::utf8Value( int index ) const
+{
+	if ( index < 0 || index >= sqlite3_data_count( m_stmt ) ) { return {}; }
+
+	// Docset indexes are UTF-8, so this hands out SQLite's buffer as is.
+	// sqlite3_column_bytes() has to come after sqlite3_column_text().
+	const auto* text{ reinterpret_cast<const char*>( sqlite3_column_text( m_stmt, index ) ) };
+
+	if ( !text ) { return {}; }
+
+	return { text, static_cast<std::size_t>( sqlite3_column_bytes( m_stmt, index ) ) };
+}
+
+QString Zeal::Util::SQLiteDatabase::stringValue( int index ) const
+{
+	const std::string_view text{ utf8Value( index ) };
+	return QString::fromUtf8( text.data(), static_cast<int>( text.size() ) );
 }
 
 QString Zeal::Util::SQLiteDatabase::lastError() const { return m_lastError; }
@@ -176,8 +297,11 @@ void Zeal::Util::SQLiteDatabase::close()
 
 void Zeal::Util::SQLiteDatabase::finalize()
 {
-	// sqlite3_finalize( m_stmt.get() );
-	// m_stmt = nullptr;
+	// Cached statements stay compiled, resetting them releases their read lock
+	if ( m_stmt && m_stmt != m_oneShotStmt.get() ) { sqlite3_reset( m_stmt ); }
+
+	m_stmt = nullptr;
+	m_oneShotStmt.reset();
 }
 
 void Zeal::Util::SQLiteDatabase::updateLastError()
@@ -188,4 +312,71 @@ void Zeal::Util::SQLiteDatabase::updateLastError()
 		QString( reinterpret_cast<const QChar*>( sqlite3_errmsg16( m_db.get() ) ) );
 }
 
+bool Zeal::Util::SQLiteDatabase::checkBind( int res )
+{
+	if ( res == SQLITE_OK ) return true;
+
+	updateLastError();
+	return false;
+}
+
+void Zeal::Util::SQLiteDatabase::applyProfile( const Profile& profile )
+{
+	const QByteArray pragmas{
+		QStringLiteral( "PRAGMA mmap_size=%1; PRAGMA cache_size=%2; "
+				"PRAGMA temp_store=%3; PRAGMA query_only=%4;" )
+			.arg( profile.mmapSize )
+			.arg( profile.cacheSize )
+			.arg( profile.tempStoreMemory ? QStringLiteral( "MEMORY" )
+						      : QStringLiteral( "DEFAULT" ) )
+			.arg( profile.queryOnly ? 1 : 0 )
+			.toUtf8() };
+
+	// None of these is fatal, the connection just keeps SQLite's defaults
+	if ( sqlite3_exec( m_db.get(), pragmas.constData(), nullptr, nullptr, nullptr ) != SQLITE_OK )
+	{
+		updateLastError();
+		qWarning( "SQL Error: %s", qPrintable( m_lastError ) );
+	}
+}
+
+qint64 Zeal::Util::SQLiteDatabase::pragmaValue( const char* pragma )
+{
+	qint64 value{ 0 };
+
+	if ( execute( QStringLiteral( "PRAGMA %1" ).arg( QLatin1String( pragma ) ) ) && next() )
+	{
+		value = int64Value( 0 );
+	}
+
+	finalize();
+	return value;
+}
+
+Zeal::Util::SQLiteDatabase::Profile Zeal::Util::SQLiteDatabase::effectiveProfile()
+{
+	Profile profile;
+
+	if ( !isOpen() ) { return profile; }
+
+	profile.mmapSize	= pragmaValue( "mmap_size" );
+	profile.cacheSize	= static_cast<int>( pragmaValue( "cache_size" ) );
+	profile.tempStoreMemory = pragmaValue( "temp_store" ) == 2;    // 2 is MEMORY
+	profile.queryOnly	= pragmaValue( "query_only" ) != 0;
+	profile.immutable	= m_immutable;
+
+	return profile;
+}
+
+QDebug Zeal::Util::operator<<( QDebug debug, const SQLiteDatabase::Profile& profile )
+{
+	const QDebugStateSaver saver{ debug };
+	debug.nospace() << "Profile(mmap_size=" << profile.mmapSize
+			<< ", cache_size=" << profile.cacheSize
+			<< ", temp_store=" << ( profile.tempStoreMemory ? "MEMORY" : "DEFAULT" )
+			<< ", query_only=" << profile.queryOnly
+			<< ", immutable=" << profile.immutable << ')';
+	return debug;
+}
+
 sqlite3* Zeal::Util::SQLiteDatabase::handle() const { return m_db.get(); }
@@ -25,9 +25,12 @@
 
 #include <sqlite3.h>
 
+#include <QDebug>
 #include <QStringList>
 #include <QVariant>
+#include <map>
 #include <memory>
+#include <string_view>
 
 /*!
  * \brief Custom deleter for sqlite3.
@@ -91,11 +94,38 @@ namespace Zeal { namespace Util {
  * \brief Constructor that initializes and attempts to open an SQLite database.
  *
  * \param path The file path to the SQLite database file.
+ * \param mode How the database is opened, see OpenMode.
+ * \param profile The performance settings applied right after opening.
  */
 class SQLiteDatabase
 {
 public:
-	explicit SQLiteDatabase( const QString& path );
+	/*!
+	 * \brief How a connection is opened.
+	 */
+	enum class OpenMode {
+		ReadWrite, /*!< Read-write with SQLite's serialized threading mode. */
+		ReadOnly   /*!< Read-only without the connection mutex, for one thread at a time. */
+	};
+
+	/*!
+	 * \brief Performance settings applied when a connection is opened.
+	 *
+	 * The defaults match plain SQLite, the plugin reads its own values from its
+	 * configuration group.
+	 */
+	struct Profile
+	{
+		qint64 mmapSize	       = 0;	 /*!< PRAGMA mmap_size in bytes, 0 disables mapping. */
+		int    cacheSize       = -2000;	 /*!< PRAGMA cache_size, negative values are KiB. */
+		bool   tempStoreMemory = false;	 /*!< PRAGMA temp_store=MEMORY for sorts. */
+		bool   queryOnly       = false;	 /*!< PRAGMA query_only, rejects all writes. */
+		bool   immutable       = false;	 /*!< The immutable URI parameter, read-only only. */
+	};
+
+	explicit SQLiteDatabase( const QString& path,
+				 OpenMode	mode	= OpenMode::ReadWrite,
+				 const Profile& profile = Profile{} );
 
 	/*!
 	 * \brief Destructor that finalizes the current statement and closes the database connection.
@@ -119,11 +149,55 @@ public:
 	/*!
 	 * \brief Executes an SQL query.
 	 *
+	 * The statement is compiled for this call only and finalized on the next one. Use
+	 * prepare() for queries that are run repeatedly or that take user input.
+	 *
 	 * \param queryStr The SQL query string to execute.
 	 * \return True if the query was executed successfully, false otherwise.
 	 */
 	bool execute( const QString& queryStr );
 
+	/*!
+	 * \brief Makes a cached prepared statement the current query.
+	 *
+	 * The statement is compiled once with `SQLITE_PREPARE_PERSISTENT` and kept for the
+	 * lifetime of the connection. Later calls with the same SQL text only reset it and
+	 * clear its bindings, so SQLite neither re-parses nor re-plans the query.
+	 *
+	 * Parameters are written as `?NNN` in \a queryStr and bound with the bind methods
+	 * below before the first call to next().
+	 *
+	 * \param queryStr The SQL query string to prepare.
+	 * \return True if the statement is ready for binding, false otherwise.
+	 */
+	bool prepare( const QString& queryStr );
+
+	/*!
+	 * \brief Binds a text value to a parameter of the current statement.
+	 *
+	 * \param index The 1-based parameter index.
+	 * \param value The value to bind; it is copied by SQLite.
+	 * \return True if the value was bound, false otherwise.
+	 */
+	bool bindText( int index, const QString& value );
+
+	/*!
+	 * \brief Binds an integer value to a parameter of the current statement.
+	 *
+	 * \param index The 1-based parameter index.
+	 * \param value The value to bind.
+	 * \return True if the value was bound, false otherwise.
+	 */
+	bool bindInt64( int index, qint64 value );
+
+	/*!
+	 * \brief Binds NULL to a parameter of the current statement.
+	 *
+	 * \param index The 1-based parameter index.
+	 * \return True if the value was bound, false otherwise.
+	 */
+	bool bindNull( int index );
+
 	/*!
 	 * \brief Advances to the next row in the result set of the current query.
 	 *
@@ -139,6 +213,43 @@ public:
 	 */
 	[[nodiscard]] QVariant value( int index ) const;
 
+	/*!
+	 * \brief Checks whether a column in the current row is NULL.
+	 *
+	 * \param index The column index to check.
+	 * \return True if the column is NULL or out of range, false otherwise.
+	 */
+	[[nodiscard]] bool isNull( int index ) const;
+
+	/*!
+	 * \brief Retrieves a column in the current row as an integer.
+	 *
+	 * \param index The column index to retrieve.
+	 * \return The value of the column, or 0 if it is NULL or out of range.
+	 */
+	[[nodiscard]] qint64 int64Value( int index ) const;
+
+	/*!
+	 * \brief Retrieves a column in the current row as UTF-8 text without copying it.
+	 *
+	 * The view points into SQLite's own row buffer and is only valid until the next
+	 * call to next(), prepare() or execute(). Convert it if the value has to be kept.
+	 *
+	 * \param index The column index to retrieve.
+	 * \return A view over the text of the column, empty if it is NULL or out of range.
+	 */
+	[[nodiscard]] std::string_view utf8Value( int index ) const;
+
+	/*!
+	 * \brief Retrieves a column in the current row as a QString.
+	 *
+	 * This is the converting counterpart of utf8Value() for values that are kept.
+	 *
+	 * \param index The column index to retrieve.
+	 * \return The text of the column, empty if it is NULL or out of range.
+	 */
+	[[nodiscard]] QString stringValue( int index ) const;
+
 	/*!
 	 * \brief Retrieves the last error message from SQLite.
 	 *
@@ -153,26 +264,61 @@ public:
 	 */
 	[[nodiscard]] sqlite3* handle() const;
 
-private:
 	/*!
-	 * \brief Closes the database connection.
+	 * \brief Reads the performance settings back from SQLite.
+	 *
+	 * This reports what the connection really uses, which differs from the requested
+	 * Profile when SQLite clamps a value (e.g. mmap_size above its compile-time limit).
+	 *
+	 * \return The settings in effect for this connection.
 	 */
-	void close();
+	[[nodiscard]] Profile effectiveProfile();
+
 	/*!
 	 * \brief Finalizes the current prepared statement.
+	 *
+	 * Cached statements are only reset, which ends their read transaction.
 	 */
 	void finalize();
+
+private:
+	/*!
+	 * \brief Closes the database connection.
+	 */
+	void close();
 	/*!
 	 * \brief Updates the last error message from SQLite.
 	 */
 	void updateLastError();
+	/*!
+	 * \brief Checks the result of a bind call and records the error, if any.
+	 */
+	bool checkBind( int res );
+	/*!
+	 * \brief Applies the pragmas of \a profile to the open connection.
+	 */
+	void applyProfile( const Profile& profile );
+	/*!
+	 * \brief Runs a pragma that returns a single integer.
+	 */
+	qint64 pragmaValue( const char* pragma );
 
-	std::unique_ptr<sqlite3, SQLite3Deleter>	  m_db;
-	std::unique_ptr<sqlite3_stmt, SQLite3StmtDeleter> m_stmt;
+	using StatementPtr = std::unique_ptr<sqlite3_stmt, SQLite3StmtDeleter>;
+
+	std::unique_ptr<sqlite3, SQLite3Deleter> m_db;
+	std::map<QString, StatementPtr>		 m_statementCache; /*!< Statements kept by prepare(). */
+	StatementPtr m_oneShotStmt;	     /*!< Statement owned by the last execute() call. */
+	sqlite3_stmt* m_stmt = nullptr; /*!< The current statement, either cached or one-shot. */
+	bool	      m_immutable = false; /*!< Opened with immutable=1, SQLite can't report it. */
 
 	QString m_lastError;
 };
 
+/*!
+ * \brief Writes a Profile in a form suitable for the logs.
+ */
+QDebug operator<<( QDebug debug, const SQLiteDatabase::Profile& profile );
+
 }}    // namespace Zeal::Util
 
 #endif	  // ZEAL_UTIL_SQLITEDATABASE_H
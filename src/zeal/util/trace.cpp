@@ -0,0 +1,269 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <chrono>
+
+namespace {
+struct Event
+{
+	const char* category;
+	const char* name;
+	qint64	    start;
+	qint64	    end;
+};
+
+const int ChunkSize{ 4096 };
+const int MaxChunks{ 256 };    // About a million spans per thread, later ones are dropped
+
+/*!
+ * \brief A block of spans, filled by its thread and read by stop().
+ *
+ * Only the owning thread writes; it publishes each span by a release store of
+ * size, so stop() reads complete spans without locking.
+ */
+struct Chunk
+{
+	Event		    events[ChunkSize];
+	std::atomic<int>    size{ 0 };
+	std::atomic<Chunk*> next{ nullptr };
+};
+
+/*!
+ * \brief The spans of one thread.
+ *
+ * Buffers live until the process exits, so spans of threads that ended are still
+ * written. A buffer belongs to the trace whose epoch it carries and is cleared by
+ * its thread when that thread records into a newer trace.
+ */
+struct ThreadBuffer
+{
+	Chunk		     first;
+	Chunk*		     current{ &first };
+	int		     chunks{ 1 };
+	std::atomic<quint64> epoch{ 0 };
+	std::atomic<qint64>  dropped{ 0 };
+	int		     tid{ 0 };
+	QString		     threadName;
+	ThreadBuffer*	     next{ nullptr };
+};
+
+std::atomic<ThreadBuffer*> buffers{ nullptr };
+std::atomic<quint64>	   currentEpoch{ 0 };
+std::atomic<qint64>	   origin{ 0 };
+std::atomic<int>	   nextTid{ 1 };
+QMutex			   controlMutex;    // Serializes start() and stop(), never taken by record()
+
+ThreadBuffer* threadBuffer()
+{
+	thread_local ThreadBuffer* buffer{ nullptr };
+
+	if ( !buffer )
+	{
+		buffer	    = new ThreadBuffer;
+		buffer->tid = nextTid.fetch_add( 1, std::memory_order_relaxed );
+
+		const QThread* thread{ QThread::currentThread() };
+
+		if ( QCoreApplication::instance() && thread == QCoreApplication::instance()->thread() )
+		{
+			buffer->threadName = QStringLiteral( "GUI" );
+		}
+		else
+		{
+			buffer->threadName = thread->objectName().isEmpty()
+						     ? QStringLiteral( "Thread %1" ).arg( buffer->tid )
+						     : thread->objectName();
+		}
+
+		buffer->next = buffers.load( std::memory_order_relaxed );
+
+		while ( !buffers.compare_exchange_weak( buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed ) ) {}
+	}
+
+	return buffer;
+}
+
+QByteArray jsonString( const QString& string )
+{
+	QByteArray result{ "\"" };
+
+	for ( const char c : string.toUtf8() )
+	{
+		if ( c == '"' || c == '\\' ) { result += '\\'; }
+
+		if ( static_cast<unsigned char>( c ) < 0x20 ) { result += "\\u00" + QByteArray::number( c, 16 ).rightJustified( 2, '0' ); }
+		else { result += c; }
+	}
+
+	return result + '"';
+}
+}    // namespace
+
+std::atomic<bool> Zeal::Util::Trace::g_enabled{ false };
+
+qint64 Zeal::Util::Trace::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() )
+		.count();
+}
+
+void Zeal::Util::Trace::start()
+{
+	QMutexLocker locker{ &controlMutex };
+
+	origin.store( now(), std::memory_order_relaxed );
+	currentEpoch.fetch_add( 1, std::memory_order_release );
+	g_enabled.store( true, std::memory_order_release );
+}
+
+void Zeal::Util::Trace::record( const char* category, const char* name, qint64 start, qint64 end )
+{
+	if ( !isEnabled() ) { return; }
+
+	ThreadBuffer* buffer{ threadBuffer() };
+	const quint64 epoch{ currentEpoch.load( std::memory_order_acquire ) };
+
+	// First span of a new trace on this thread, the old spans were already written
+	if ( buffer->epoch.load( std::memory_order_relaxed ) != epoch )
+	{
+		for ( Chunk* chunk = &buffer->first; chunk; chunk = chunk->next.load( std::memory_order_relaxed ) )
+		{
+			chunk->size.store( 0, std::memory_order_relaxed );
+		}
+
+		buffer->current = &buffer->first;
+		buffer->dropped.store( 0, std::memory_order_relaxed );
+		buffer->epoch.store( epoch, std::memory_order_release );
+	}
+
+	Chunk* chunk{ buffer->current };
+	int    size{ chunk->size.load( std::memory_order_relaxed ) };
+
+	if ( size == ChunkSize )
+	{
+		Chunk* next{ chunk->next.load( std::memory_order_relaxed ) };
+
+		if ( !next )
+		{
+			if ( buffer->chunks == MaxChunks )
+			{
+				buffer->dropped.fetch_add( 1, std::memory_order_relaxed );
+				return;
+			}
+
+			next = new Chunk;
+			++buffer->chunks;
+			chunk->next.store( next, std::memory_order_release );
+		}
+
+		chunk = buffer->current = next;
+		size			= 0;
+	}
+
+	chunk->events[size] = Event{ category, name, start, end };
+	chunk->size.store( size + 1, std::memory_order_release );
+}
+
+bool Zeal::Util::Trace::stop( const QString& fileName )
+{
+	QMutexLocker locker{ &controlMutex };
+
+	if ( !g_enabled.exchange( false, std::memory_order_acq_rel ) ) { return false; }
+
+	const quint64	 epoch{ currentEpoch.load( std::memory_order_acquire ) };
+	const qint64	 zero{ origin.load( std::memory_order_relaxed ) };
+	const QByteArray pid{ QByteArray::number( QCoreApplication::applicationPid() ) };
+
+	QSaveFile file{ fileName };
+
+	if ( !file.open( QIODevice::WriteOnly ) )
+	{
+		qWarning() << "Can't write trace" << fileName << file.errorString();
+		return false;
+	}
+
+	QByteArray json{ "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" };
+	bool	   first{ true };
+	qint64	   dropped{ 0 };
+
+	const auto append = [&]( const QByteArray& event ) {
+		json += first ? "" : ",\n";
+		json += event;
+		first = false;
+
+		if ( json.size() > ( 1 << 20 ) )
+		{
+			file.write( json );
+			json.clear();
+		}
+	};
+
+	for ( ThreadBuffer* buffer = buffers.load( std::memory_order_acquire ); buffer; buffer = buffer->next )
+	{
+		// Threads that recorded nothing since start() only hold older spans
+		if ( buffer->epoch.load( std::memory_order_acquire ) != epoch ) { continue; }
+
+		const QByteArray tid{ QByteArray::number( buffer->tid ) };
+
+		append( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+			+ ",\"args\":{\"name\":" + jsonString( buffer->threadName ) + "}}" );
+
+		for ( const Chunk* chunk = &buffer->first; chunk; chunk = chunk->next.load( std::memory_order_acquire ) )
+		{
+			const int size{ chunk->size.load( std::memory_order_acquire ) };
+
+			for ( int i = 0; i < size; ++i )
+			{
+				const Event& event{ chunk->events[i] };
+
+				// Chrome traces count in microseconds
+				append( "{\"name\":\"" + QByteArray( event.name ) + "\",\"cat\":\"" + QByteArray( event.category )
+					+ "\",\"ph\":\"X\",\"ts\":" + QByteArray::number( ( event.start - zero ) / 1000.0, 'f', 3 )
+					+ ",\"dur\":" + QByteArray::number( ( event.end - event.start ) / 1000.0, 'f', 3 )
+					+ ",\"pid\":" + pid + ",\"tid\":" + tid + "}" );
+			}
+		}
+
+		dropped += buffer->dropped.load( std::memory_order_relaxed );
+	}
+
+	json += "\n]}\n";
+	file.write( json );
+
+	if ( dropped > 0 ) { qWarning() << "Trace buffers were full," << dropped << "spans were dropped"; }
+
+	if ( !file.commit() )
+	{
+		qWarning() << "Can't write trace" << fileName << file.errorString();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,124 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef ZEAL_UTIL_TRACE_H
+#define ZEAL_UTIL_TRACE_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+namespace Zeal { namespace Util {
+
+/*!
+ * \brief Records timed spans and writes them as a Chrome trace.
+ *
+ * Tracing is off by default and costs one relaxed atomic load per span then. While
+ * it runs, every thread appends its spans to a buffer of its own without taking a
+ * lock, and stop() writes all of them as Chrome trace JSON that Perfetto and
+ * chrome://tracing load.
+ *
+ * Spans are recorded with ZEAL_TRACE_SPAN(), names and categories must be string
+ * literals because only their pointers are kept.
+ */
+namespace Trace {
+
+extern std::atomic<bool> g_enabled; /*!< Set by start(), cleared by stop(). */
+
+/*!
+ * \brief Returns true while spans are recorded.
+ */
+inline bool isEnabled() { return g_enabled.load( std::memory_order_relaxed ); }
+
+/*!
+ * \brief Discards earlier spans and starts recording.
+ */
+void start();
+
+/*!
+ * \brief Stops recording and writes the spans to \a fileName.
+ * \return False if tracing wasn't running or the file couldn't be written.
+ */
+bool stop( const QString& fileName );
+
+/*!
+ * \brief Returns the current time on the trace clock, in nanoseconds.
+ */
+qint64 now();
+
+/*!
+ * \brief Appends a finished span to the calling thread's buffer.
+ */
+void record( const char* category, const char* name, qint64 start, qint64 end );
+
+/*!
+ * \class Span
+ * \brief Records the time between its construction and its destruction.
+ *
+ * Spans shorter than \a minimumNs are dropped, which keeps hot, usually fast calls
+ * like SQLite steps from flooding the trace while still showing their stalls.
+ */
+class Span
+{
+public:
+	Span( const char* category, const char* name, qint64 minimumNs = 0 )
+		: m_category{ category }
+		, m_name{ name }
+		, m_minimum{ minimumNs }
+		, m_start{ isEnabled() ? now() : -1 }
+	{
+	}
+
+	~Span()
+	{
+		if ( m_start < 0 ) { return; }
+
+		const qint64 end{ now() };
+
+		if ( end - m_start >= m_minimum ) { record( m_category, m_name, m_start, end ); }
+	}
+
+	Span( const Span& )	       = delete;
+	Span& operator=( const Span& ) = delete;
+
+private:
+	const char* m_category;
+	const char* m_name;
+	qint64	    m_minimum;
+	qint64	    m_start;
+};
+
+}    // namespace Trace
+}}    // namespace Zeal::Util
+
+#define ZEAL_TRACE_CONCAT_( a, b ) a##b
+#define ZEAL_TRACE_CONCAT( a, b ) ZEAL_TRACE_CONCAT_( a, b )
+
+/*!
+ * \brief Records the rest of the enclosing scope as a span of \a category named \a name.
+ *
+ * An optional third argument is the minimum duration in nanoseconds, see Trace::Span.
+ */
+#define ZEAL_TRACE_SPAN( category, ... ) \
+	const Zeal::Util::Trace::Span ZEAL_TRACE_CONCAT( zealTraceSpan, __LINE__ ) { category, __VA_ARGS__ }
+
+#endif	  // ZEAL_UTIL_TRACE_H
@@ -0,0 +1,274 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "zealdeclarationcache.h"
+
+#include <language/duchain/classfunctiondeclaration.h>
+#include <language/duchain/declaration.h>
+#include <language/duchain/duchain.h>
+#include <language/duchain/duchainlock.h>
+#include <language/duchain/indexeddeclaration.h>
+#include <language/duchain/parsingenvironment.h>
+#include <language/duchain/topducontext.h>
+#include <language/duchain/types/functiontype.h>
+
+#include <QMutexLocker>
+#include <QRegularExpression>
+
+#include "zealdocprovider.h"
+
+namespace {
+quint64 cacheKey( uint topContextIndex, uint localIndex )
+{
+	return ( quint64( topContextIndex ) << 32 ) | localIndex;
+}
+}    // namespace
+
+ZealDeclarationCache::ZealDeclarationCache( QObject* parent )
+	: QObject{ parent }
+{
+	// Direct, so entries are gone before anyone can look the new declarations up
+	connect( KDevelop::DUChain::self(),
+		 &KDevelop::DUChain::updateReady,
+		 this,
+		 &ZealDeclarationCache::updateReady,
+		 Qt::DirectConnection );
+}
+
+ZealDeclarationCache::~ZealDeclarationCache() = default;
+
+int ZealDeclarationCache::resolve( const ZealdocProvider* provider, KDevelop::Declaration* dec )
+{
+	quint64 key;
+	Entry	described;
+
+	{
+		const KDevelop::DUChainReadLocker lock;
+		const KDevelop::IndexedDeclaration indexed{ dec };
+
+		key = cacheKey( indexed.topContextIndex(), indexed.localIndex() );
+
+		const QMutexLocker locker{ &m_mutex };
+		const auto	   it{ m_entries.constFind( key ) };
+
+		if ( it != m_entries.constEnd() )
+		{
+			for ( const auto& row : it->rows )
+			{
+				if ( row.first == provider ) { return row.second; }
+			}
+
+			described      = *it;
+			described.rows = {};
+		}
+		else
+		{
+			described = describe( dec );
+		}
+	}
+
+	bool routed;
+
+	{
+		const QMutexLocker locker{ &m_mutex };
+		routed = routes( described.language, provider );
+	}
+
+	// A miss for other languages' docsets, without loading their tables
+	int row{ -1 };
+
+	if ( !described.token.isEmpty() && routed )
+	{
+		// Held until the lookup is done, another thread may drop it from the provider
+		const auto table{ provider->tokens() };
+		const int  index{ table->indexOfClosest( described.token ) };
+
+		if ( index >= 0 ) { row = table->bestEntry( index, described.groups, described.words ); }
+	}
+
+	const QMutexLocker locker{ &m_mutex };
+
+	if ( m_entries.size() >= MaxEntries && !m_entries.contains( key ) ) { m_entries.clear(); }
+
+	Entry& entry{ m_entries[ key ] };
+
+	if ( entry.token.isEmpty() )
+	{
+		described.rows = entry.rows;
+		entry	       = described;
+	}
+
+	entry.rows.append( { provider, row } );
+
+	return row;
+}
+
+void ZealDeclarationCache::clear()
+{
+	const QMutexLocker locker{ &m_mutex };
+	m_entries.clear();
+}
+
+void ZealDeclarationCache::setLanguageKeywords( const QHash<QString, QStringList>& keywords )
+{
+	const QMutexLocker locker{ &m_mutex };
+
+	m_entries.clear();
+	m_languageKeywords.clear();
+
+	for ( auto it = keywords.cbegin(); it != keywords.cend(); ++it )
+	{
+		// Both sides are folded, the configuration may spell the language differently
+		QStringList& lowered{ m_languageKeywords[ it.key().toLower() ] };
+
+		for ( const QString& keyword : it.value() ) { lowered << keyword.toLower(); }
+	}
+}
+
+bool ZealDeclarationCache::routes( const QString& language, const ZealdocProvider* provider ) const
+{
+	const auto it{ m_languageKeywords.constFind( language.toLower() ) };
+
+	if ( it == m_languageKeywords.constEnd() || it->isEmpty() || provider->keywords().isEmpty() ) { return true; }
+
+	for ( const QString& keyword : provider->keywords() )
+	{
+		if ( it->contains( keyword ) ) { return true; }
+	}
+
+	return false;
+}
+
+void ZealDeclarationCache::updateReady( const KDevelop::IndexedString&,
+					const KDevelop::ReferencedTopDUContext& topContext )
+{
+	if ( !topContext ) { return; }
+
+	const quint64	   topIndex{ topContext->ownIndex() };
+	const QMutexLocker locker{ &m_mutex };
+
+	for ( auto it = m_entries.begin(); it != m_entries.end(); )
+	{
+		if ( ( it.key() >> 32 ) == topIndex ) { it = m_entries.erase( it ); }
+		else { ++it; }
+	}
+}
+
+ZealDeclarationCache::Entry ZealDeclarationCache::describe( KDevelop::Declaration* dec )
+{
+	static const KDevelop::IndexedString qmlJs{ "QML/JS" };
+
+	Entry entry;
+	entry.token = dec->qualifiedIdentifier().toString( KDevelop::RemoveTemplateInformation );
+
+	const auto* topContext{ dec->topContext() };
+	const auto  environment{ topContext ? topContext->parsingEnvironmentFile()
+					    : KDevelop::ParsingEnvironmentFilePointer{} };
+
+	if ( environment ) { entry.language = environment->language().str(); }
+
+	if ( environment && environment->language() == qmlJs && !entry.token.isEmpty() )
+	{
+		entry.token = QLatin1String( "QML." ) + entry.token;
+	}
+
+	// Docset groups (parsed symbol types) that fit the declaration, best first
+	const auto* context{ dec->context() };
+	const bool  member{ context && context->type() == KDevelop::DUContext::Class };
+
+	switch ( dec->kind() )
+	{
+		case KDevelop::Declaration::Type:
+		case KDevelop::Declaration::Alias:
+			entry.groups = QStringList{ QStringLiteral( "Class" ),	   QStringLiteral( "Struct" ),
+						    QStringLiteral( "Type" ),	   QStringLiteral( "Enumeration" ),
+						    QStringLiteral( "Union" ),	   QStringLiteral( "Protocol" ),
+						    QStringLiteral( "Interface" ), QStringLiteral( "Trait" ) };
+			break;
+
+		case KDevelop::Declaration::Namespace:
+		case KDevelop::Declaration::NamespaceAlias:
+			entry.groups = QStringList{ QStringLiteral( "Namespace" ),
+						    QStringLiteral( "Module" ),
+						    QStringLiteral( "Package" ) };
+			break;
+
+		case KDevelop::Declaration::Macro:
+			entry.groups = QStringList{ QStringLiteral( "Macro" ), QStringLiteral( "Define" ) };
+			break;
+
+		default:
+			if ( dec->isFunctionDeclaration() )
+			{
+				const auto* classFunction{ dynamic_cast<const KDevelop::ClassFunctionDeclaration*>( dec ) };
+
+				if ( classFunction && classFunction->isConstructor() )
+				{
+					entry.groups << QStringLiteral( "Constructor" );
+				}
+
+				entry.groups << ( member ? QStringList{ QStringLiteral( "Method" ), QStringLiteral( "Function" ) }
+							 : QStringList{ QStringLiteral( "Function" ), QStringLiteral( "Method" ) } )
+					     << QStringLiteral( "Operator" );
+			}
+			else if ( member )
+			{
+				entry.groups = QStringList{ QStringLiteral( "Attribute" ), QStringLiteral( "Property" ),
+							    QStringLiteral( "Field" ),	   QStringLiteral( "Variable" ),
+							    QStringLiteral( "Constant" ) };
+			}
+			else
+			{
+				entry.groups = QStringList{ QStringLiteral( "Variable" ),
+							    QStringLiteral( "Constant" ),
+							    QStringLiteral( "Global" ) };
+			}
+			break;
+	}
+
+	// Parameter types, matched against overload anchors that spell them out
+	if ( const auto function = dec->type<KDevelop::FunctionType>() )
+	{
+		static const QRegularExpression nonWord{ QStringLiteral( "[^A-Za-z0-9_]+" ) };
+		static const QStringList	qualifiers{ QStringLiteral( "const" ),
+						    QStringLiteral( "volatile" ),
+						    QStringLiteral( "struct" ),
+						    QStringLiteral( "class" ),
+						    QStringLiteral( "enum" ) };
+
+		for ( const auto& argument : function->arguments() )
+		{
+			if ( !argument ) { continue; }
+
+			const auto words{ argument->toString().split( nonWord ) };
+
+			for ( const QString& word : words )
+			{
+				if ( word.size() > 1 && !qualifiers.contains( word ) ) { entry.words << word; }
+			}
+		}
+
+		entry.words.removeDuplicates();
+	}
+
+	return entry;
+}
@@ -0,0 +1,133 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+namespace KDevelop {
+class Declaration;
+class IndexedString;
+class ReferencedTopDUContext;
+}    // namespace KDevelop
+
+class ZealdocProvider;
+
+/*!
+ * \class ZealDeclarationCache
+ * \brief Remembers which entry each provider resolved a declaration to.
+ *
+ * Turning a declaration into a docset token needs the DUChain lock, a qualified
+ * identifier rendered to a string and a look at the declaration's language. KDevelop
+ * asks every provider for every hover and F1 press, so the same declaration is
+ * resolved over and over. The cache keeps the token of each declaration and, per
+ * provider, the row it was found at, including misses.
+ *
+ * Entries are keyed by the declaration's (top context, local) index pair. They are
+ * dropped when their top context is updated, and everything is cleared when the
+ * providers are reloaded.
+ *
+ * Declarations are also routed by language: a provider whose docset keywords don't
+ * belong to the declaration's language gets a miss without its table being touched.
+ * Languages without keywords, and docsets without keywords, are not routed.
+ */
+class ZealDeclarationCache: public QObject
+{
+	Q_OBJECT
+	Q_DISABLE_COPY_MOVE( ZealDeclarationCache )
+
+public:
+	/*!
+	 * \brief Constructs the cache and subscribes it to DUChain updates.
+	 * \param parent The parent object.
+	 */
+	explicit ZealDeclarationCache( QObject* parent );
+
+	/*!
+	 * \brief Destroys the cache.
+	 */
+	~ZealDeclarationCache() override;
+
+	/*!
+	 * \brief Resolves \a dec against the token table of \a provider.
+	 *
+	 * When the token has several entries (overloads, same-named members), the one
+	 * matching the declaration's kind and parameter types is picked.
+	 *
+	 * \param provider The provider asking.
+	 * \param dec The declaration, must not be null.
+	 * \return The entry in the provider's table, or -1 if it has none.
+	 */
+	int resolve( const ZealdocProvider* provider, KDevelop::Declaration* dec );
+
+	/*!
+	 * \brief Drops every entry, used when providers come and go.
+	 */
+	void clear();
+
+	/*!
+	 * \brief Sets which docset keywords serve which language, and clears the cache.
+	 * \param keywords Docset keywords by KDevelop language name.
+	 */
+	void setLanguageKeywords( const QHash<QString, QStringList>& keywords );
+
+private:
+	/*!
+	 * \brief What is known about one declaration.
+	 */
+	struct Entry
+	{
+		QString						 token;	    /*!< Token the declaration maps to. */
+		QString						 language;  /*!< Language the declaration was parsed as. */
+		QStringList					 groups;    /*!< Docset groups fitting its kind, best first. */
+		QStringList					 words;	    /*!< Parameter type words, for overloads. */
+		QVector<QPair<const ZealdocProvider*, int>> rows;	    /*!< Entry per provider, -1 for misses. */
+	};
+
+	/*!
+	 * \brief Drops the entries of the top context that was just updated.
+	 */
+	void updateReady( const KDevelop::IndexedString& url, const KDevelop::ReferencedTopDUContext& topContext );
+
+	/*!
+	 * \brief Builds the token, language, groups and words of \a dec. The DUChain must be read-locked.
+	 */
+	static Entry describe( KDevelop::Declaration* dec );
+
+	/*!
+	 * \brief Checks whether \a provider documents \a language. Needs m_mutex.
+	 */
+	bool routes( const QString& language, const ZealdocProvider* provider ) const;
+
+	/*!
+	 * \brief The cache is cleared rather than grown past this many declarations.
+	 */
+	static constexpr int MaxEntries = 8192;
+
+	QMutex		       m_mutex;	     /*!< Guards m_entries, lookups come from any thread. */
+	QHash<quint64, Entry> m_entries;    /*!< Keyed by top context index << 32 | local index. */
+	QHash<QString, QStringList> m_languageKeywords; /*!< Lowercased docset keywords by lowercased language. */
+};
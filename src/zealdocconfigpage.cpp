@@ -23,12 +23,26 @@
 #include <KLineEdit>
 #include <KMessageWidget>
 #include <KSharedConfig>
+#include <QIcon>
+#include <QLocale>
+#include <QtConcurrent>
+#include <algorithm>
 
 #include "debug.h"
 #include "kdevzealdoc.h"
 #include "ui_zealdocconfigpage.h"
 #include "util.h"
 
+namespace {
+// Item data of the docset entries
+enum DocsetRole {
+	TitleRole = Qt::UserRole,
+	SymbolCountRole,
+	LoadTimeRole,
+	MemoryUsageRole
+};
+}    // namespace
+
 ZealdocConfigPage::ZealdocConfigPage( KDevelop::IPlugin* plugin, QWidget* parent )
 	: ConfigPage{ plugin, nullptr, parent }
 	, m_ui{ std::make_unique<Ui::ZealdocConfigPage>() }
@@ -50,38 +64,132 @@ ZealdocConfigPage::ZealdocConfigPage( KDevelop::IPlugin* plugin, QWidget* parent
 	reloadDocsets( docsetsPath() );
 
 	connect( m_ui->docsetsList, &QListWidget::itemChanged, this, [this]( QListWidgetItem* ) {
+		updateTotals();
 		emit changed();
 	} );
 
-	connect( m_ui->kcfg_docsetsPath,
-		 &KUrlRequester::textChanged,
-		 this,
-		 [this]( const QString& path ) { reloadDocsets( path ); } );
+	// Wait for the user to stop typing before opening any docset
+	m_scanTimer.setSingleShot( true );
+	m_scanTimer.setInterval( 300 );
+
+	connect( &m_scanTimer, &QTimer::timeout, this, [this] {
+		reloadDocsets( m_ui->kcfg_docsetsPath->text() );
+	} );
+
+	connect( m_ui->kcfg_docsetsPath, &KUrlRequester::textChanged, this, [this]( const QString& ) {
+		m_scanToken.cancel();
+		m_scanTimer.start();
+	} );
 }
 
-ZealdocConfigPage::~ZealdocConfigPage() = default;
+ZealdocConfigPage::~ZealdocConfigPage()
+{
+	// Scans post to this page, they must be done before the page goes
+	m_scanToken.cancel();
+
+	for ( auto& scan : m_scans ) { scan.waitForFinished(); }
+}
 
 void ZealdocConfigPage::reloadDocsets( const QString& path )
 {
-	const QStringList enabled{ enabledDocsets() };
+	m_scanToken.cancel();
+	m_scanToken = Zeal::Registry::CancellationToken{};
 
 	m_ui->docsetsList->clear();
+	updateTotals();
+
+	// Only the scans still running need waiting for
+	m_scans.erase( std::remove_if( m_scans.begin(), m_scans.end(),
+				       []( const QFuture<void>& scan ) { return scan.isFinished(); } ),
+		       m_scans.end() );
+
+	// KConfig isn't thread-safe, the scan gets the profile from here
+	m_scans << QtConcurrent::run( [this, path, profile = docsetDatabaseProfile(), token = m_scanToken] {
+		scanDocsets( path, profile, token, [this, token]( const DocsetInformation& docset ) {
+			QMetaObject::invokeMethod(
+				this,
+				[this, token, docset] {
+					// Docsets of a stale scan may still be queued
+					if ( !token.isCanceled() ) { addDocset( docset ); }
+				},
+				Qt::QueuedConnection );
+		} );
+	} );
+}
+
+void ZealdocConfigPage::addDocset( const DocsetInformation& docset )
+{
+	const QLocale	  locale;
+	const DocsetStats stats{ docsetStats( docset.title ) };
+
+	QStringList costs{ i18np( "1 symbol", "%1 symbols", docset.symbolCount ),
+			   i18n( "%1 index", locale.formattedDataSize( docset.indexSize ) ) };
+
+	if ( stats.loadTime >= 0 )
+	{
+		costs << i18n( "loads in %1 ms", stats.loadTime )
+		      << i18n( "%1 in memory", locale.formattedDataSize( stats.memoryUsage ) );
+	}
+	else { costs << i18n( "not loaded yet" ); }
+
+	// Set up before inserting, so the list doesn't report a change
+	auto item{ new QListWidgetItem };
+	item->setText( docset.title + QLatin1Char( '\n' ) + costs.join( QStringLiteral( " · " ) ) );
+	item->setIcon( QIcon{ docset.iconPath } );
+	item->setData( TitleRole, docset.title );
+	item->setData( SymbolCountRole, docset.symbolCount );
+	item->setData( LoadTimeRole, stats.loadTime );
+	item->setData( MemoryUsageRole, stats.memoryUsage );
+	item->setCheckState( enabledDocsets().contains( docset.title ) ? Qt::Checked : Qt::Unchecked );
+
+	m_ui->docsetsList->addItem( item );
+	updateTotals();
+}
 
-	for ( const auto& docsetInformation : availableDocsets( path ) )
+void ZealdocConfigPage::updateTotals()
+{
+	int    docsets{ 0 };
+	int    symbols{ 0 };
+	qint64 loadTime{ 0 };
+	qint64 memoryUsage{ 0 };
+	int    unmeasured{ 0 };
+
+	for ( int i = 0; i < m_ui->docsetsList->count(); i++ )
 	{
-		// Skip invalid docsets
-		if ( !docsetInformation.isValid ) { continue; }
+		const QListWidgetItem* item{ m_ui->docsetsList->item( i ) };
+
+		if ( item->checkState() != Qt::Checked ) { continue; }
 
-		auto item{ new QListWidgetItem( m_ui->docsetsList ) };
-		item->setText( docsetInformation.title );
-		item->setIcon( docsetInformation.icon );
+		++docsets;
+		symbols += item->data( SymbolCountRole ).toInt();
 
-		if ( enabled.contains( docsetInformation.title ) )
+		if ( item->data( LoadTimeRole ).toLongLong() < 0 )
 		{
-			item->setCheckState( Qt::Checked );
+			++unmeasured;
+			continue;
 		}
-		else { item->setCheckState( Qt::Unchecked ); }
+
+		loadTime += item->data( LoadTimeRole ).toLongLong();
+		memoryUsage += item->data( MemoryUsageRole ).toLongLong();
 	}
+
+	QString totals{ i18np( "1 docset enabled", "%1 docsets enabled", docsets ) };
+
+	if ( docsets > 0 )
+	{
+		totals += i18np( ", 1 symbol", ", %1 symbols", symbols )
+			  + i18n( ": about %1 in memory and %2 ms to load.",
+				  QLocale{}.formattedDataSize( memoryUsage ), loadTime );
+	}
+
+	if ( unmeasured > 0 )
+	{
+		totals += QLatin1Char( ' ' )
+			  + i18np( "1 of them was never loaded and isn't counted.",
+				   "%1 of them were never loaded and aren't counted.", unmeasured );
+	}
+
+	m_ui->totalsLabel->setText( totals );
 }
 
 KDevelop::ConfigPage::ConfigPageType ZealdocConfigPage::configPageType() const
@@ -104,12 +212,26 @@ QIcon ZealdocConfigPage::icon() const
 void ZealdocConfigPage::apply()
 {
 	QStringList enabled;
+	QStringList listed;
 
 	for ( int i = 0; i < m_ui->docsetsList->count(); i++ )
 	{
 		const QListWidgetItem* item{ m_ui->docsetsList->item( i ) };
 
-		if ( item->checkState() == Qt::Checked ) { enabled << item->text(); }
+		const QString title{ item->data( TitleRole ).toString() };
+
+		if ( item->checkState() == Qt::Checked ) { enabled << title; }
+
+		listed << title;
+	}
+
+	// Don't disable the docsets a running scan hasn't listed yet
+	if ( !m_scans.isEmpty() && m_scans.last().isRunning() )
+	{
+		for ( const QString& title : enabledDocsets() )
+		{
+			if ( !listed.contains( title ) ) { enabled << title; }
+		}
 	}
 
 	KConfigGroup config{ KSharedConfig::openConfig(), "Zealdoc" };
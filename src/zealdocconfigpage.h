@@ -20,7 +20,11 @@
 #pragma once
 
 #include <interfaces/configpage.h>
+#include <registry/cancellationtoken.h>
 
+#include <QFuture>
+#include <QList>
+#include <QTimer>
 #include <memory>
 
 namespace Ui {
@@ -28,6 +32,7 @@ class ZealdocConfigPage;
 }
 
 class ZealdocPlugin;
+struct DocsetInformation;
 
 /*!
  * \class ZealdocConfigPage
@@ -35,6 +40,10 @@ class ZealdocPlugin;
  *
  * This class implements the configuration interface for the Zeal documentation plugin, allowing users to
  * configure the path to Zeal docsets and manage which docsets are enabled.
+ *
+ * Opening a docset reads its database, so docsets are scanned on a worker thread
+ * and listed as they are found. Edits of the path are debounced, and a new scan
+ * cancels the previous one.
  */
 class ZealdocConfigPage: public KDevelop::ConfigPage
 {
@@ -95,11 +104,27 @@ public:
 
 private:
 	/*!
-	 * \brief Reloads the docsets from the specified path.
+	 * \brief Starts listing the docsets from the specified path, cancelling the running scan.
 	 * \param path The path to the docsets.
 	 */
 	void reloadDocsets( const QString& path );
 
+	/*!
+	 * \brief Adds a docset found by the running scan to the list.
+	 *
+	 * The entry shows what the docset costs, from the scan and from the stats the
+	 * providers recorded.
+	 */
+	void addDocset( const DocsetInformation& docset );
+
+	/*!
+	 * \brief Shows what the checked docsets cost together.
+	 */
+	void updateTotals();
+
 	std::unique_ptr<Ui::ZealdocConfigPage> m_ui; /*!< The user interface for the configuration page. */
 	ZealdocPlugin* m_plugin; /*!< The plugin associated with this configuration page. */
+	QTimer	       m_scanTimer;	/*!< Debounces edits of the path. */
+	QList<QFuture<void>> m_scans; /*!< Unfinished scans, cancelled ones may still be finishing a docset. */
+	Zeal::Registry::CancellationToken m_scanToken; /*!< Cancels the running scan. */
 };
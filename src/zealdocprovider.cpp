@@ -19,68 +19,52 @@
 
 #include "zealdocprovider.h"
 
-#include <language/duchain/declaration.h>
-#include <language/duchain/duchain.h>
-#include <language/duchain/duchainlock.h>
-
+#include <KLocalizedString>
 #include <KPluginFactory>
+#include <QElapsedTimer>
 #include <QRegularExpression>
 #include <QStringList>
 
 #include "debug.h"
 #include "registry/docset.h"
+#include "registry/documentarchive.h"
+#include "util/trace.h"
+#include "util.h"
+#include "zealdeclarationcache.h"
 #include "zealdocumentation.h"
-
-ZealdocProvider::ZealdocProvider( const QString& docsetPath, QObject* parent )
+#include "zealfulltextindex.h"
+#include "zealindexmodel.h"
+#include "zealmemorybudget.h"
+
+ZealdocProvider::ZealdocProvider( const QString&	docsetPath,
+				  ZealDeclarationCache* cache,
+				  ZealMemoryBudget*	budget,
+				  ZealSnippetIndex*	snippets,
+				  QObject*		parent )
+	: ZealdocProvider{ QStringList{ docsetPath }, cache, budget, snippets, parent }
+{}
+
+ZealdocProvider::ZealdocProvider( const QStringList&	docsetPaths,
+				  ZealDeclarationCache* cache,
+				  ZealMemoryBudget*	budget,
+				  ZealSnippetIndex*	snippets,
+				  QObject*		parent )
 	: QObject{ parent }
+	, m_docsetPaths{ docsetPaths }
+	, m_profile{ docsetDatabaseProfile() }
+	, m_priorities{ docsetPriorities() }
+	, m_cache{ cache }
+	, m_budget{ budget }
+	, m_snippets{ snippets }
 {
-	const Zeal::Registry::Docset ds{ docsetPath };
-
-	m_isValid = ds.isValid();
+	m_tokens  = load();
+	m_isValid = m_tokens != nullptr;
 
 	if ( !isValid() ) { return; }
 
-	m_name = ds.title();
-	m_icon = ds.icon();
-
-	QStringList allTokens;
-
-	QMap<QString, int>	   tokenGroups{ ds.symbolCounts() };
-	QMapIterator<QString, int> i{ tokenGroups };
-
-	while ( i.hasNext() )
-	{
-		i.next();
-
-		const QString groupName{ i.key() };
-		auto	      groupTokens{ ds.symbols( groupName ) };
-
-		if ( !groupTokens.isEmpty() ) { m_tokenGroups << groupName; }
-
-		QMapIterator<QString, QUrl> j{ groupTokens };
-
-		while ( j.hasNext() )
-		{
-			j.next();
-
-			const QString token{ j.key() };
-			const QUrl    url{ j.value() };
-
-			m_tokenUrls[token] = url;
-			m_groupTokens[groupName] << token;
-		}
-	}
-
-	QMapIterator<QString, QUrl> k{ m_tokenUrls };
-
-	while ( k.hasNext() )
-	{
-		k.next();
-		allTokens << k.key();
-	}
-
-	m_model = new QStringListModel( this );
-	m_model->setStringList( allTokens );
+	m_lastUsed   = m_budget->stamp();
+	m_tokenCount = m_tokens->size();
+	m_model	     = new ZealIndexModel( this, this );
 }
 
 ZealdocProvider::~ZealdocProvider() = default;
@@ -99,31 +83,14 @@ KDevelop::IDocumentation::Ptr ZealdocProvider::homePage() const
 
 KDevelop::IDocumentation::Ptr ZealdocProvider::documentation( const QUrl& url ) const
 {
-	auto token{ m_tokenUrls.key( url ) };
-	return documentationForToken( token );
+	return documentationForEntry( tokens()->entryOfUrl( url ) );
 }
 
 KDevelop::IDocumentation::Ptr ZealdocProvider::documentationForDeclaration( KDevelop::Declaration* dec ) const
 {
-	if ( dec )
-	{
-		static const KDevelop::IndexedString qmlJs{ "QML/JS" };
-		QString				     token;
-
-		{
-			const KDevelop::DUChainReadLocker lock;
-			token = dec->qualifiedIdentifier().toString(
-				KDevelop::RemoveTemplateInformation );
-
-			if ( dec->topContext()->parsingEnvironmentFile()->language() == qmlJs
-			     && !token.isEmpty() )
-			{
-				token = QLatin1String( "QML." ) + token;
-			}
-		}
+	ZEAL_TRACE_SPAN( "provider", "ZealdocProvider::documentationForDeclaration" );
 
-		return documentationForToken( token );
-	}
+	if ( dec ) { return documentationForEntry( m_cache->resolve( this, dec ) ); }
 
 	return {};
 }
@@ -135,31 +102,239 @@ KDevelop::IDocumentation::Ptr ZealdocProvider::documentationForIndex( const QMod
 
 KDevelop::IDocumentation::Ptr ZealdocProvider::documentationForToken( const QString& token ) const
 {
-	if ( !token.isEmpty() )
+	ZEAL_TRACE_SPAN( "provider", "ZealdocProvider::documentationForToken" );
+
+	const auto table{ tokens() };
+	const int  index{ token.isEmpty() ? -1 : table->indexOf( token ) };
+
+	return documentationForEntry( index >= 0 ? table->firstEntry( index ) : -1 );
+}
+
+KDevelop::IDocumentation::Ptr ZealdocProvider::documentationForEntry( int entry ) const
+{
+	const auto table{ tokens() };
+
+	if ( entry >= 0 && entry < table->entryCount() )
 	{
-		const QUrl url{ m_tokenUrls[token] };
+		const QUrl url{ table->entryUrl( entry ) };
 
 		if ( url.isValid() )
 		{
 			ZealDocumentation::m_provider = const_cast<ZealdocProvider*>( this );
 			return KDevelop::IDocumentation::Ptr(
-				new ZealDocumentation( token, url ) );
+				new ZealDocumentation( table->tokenString( table->entryToken( entry ) ), url, m_snippets ) );
 		}
 	}
 
 	return {};
 }
 
+KDevelop::IDocumentation::Ptr ZealdocProvider::documentationForPage( const QString& title, const QUrl& url ) const
+{
+	ZealDocumentation::m_provider = const_cast<ZealdocProvider*>( this );
+	return KDevelop::IDocumentation::Ptr( new ZealDocumentation( title, url, m_snippets ) );
+}
+
+ZealFullTextIndex* ZealdocProvider::fullTextIndex() const
+{
+	if ( !m_fullText )
+	{
+		m_fullText = new ZealFullTextIndex{ m_documentPaths, const_cast<ZealdocProvider*>( this ) };
+		m_fullText->update();
+	}
+
+	return m_fullText;
+}
+
 QAbstractListModel* ZealdocProvider::indexModel() const { return m_model; }
 
-QStringList ZealdocProvider::tokenGroups() const { return m_tokenGroups; }
+QStringList ZealdocProvider::tokenGroups() const { return tokens()->groupNames(); }
 
-QIcon ZealdocProvider::groupIcon( const QString& group )
+std::shared_ptr<const ZealTokenTable> ZealdocProvider::tokens() const
 {
-	return QIcon::fromTheme( QStringLiteral( "zealdoc_%1" ).arg( group.toLower() ) );
+	static const auto empty{ std::make_shared<const ZealTokenTable>() };
+
+	if ( !m_isValid ) { return empty; }
+
+	m_lastUsed = m_budget->stamp();
+
+	{
+		const QMutexLocker locker{ &m_tokensMutex };
+
+		if ( m_tokens ) { return m_tokens; }
+	}
+
+	std::shared_ptr<const ZealTokenTable> table;
+
+	{
+		const QMutexLocker loadLocker{ &m_loadMutex };
+
+		{
+			// Another thread may have rebuilt it while this one waited
+			const QMutexLocker locker{ &m_tokensMutex };
+			table = m_tokens;
+		}
+
+		if ( table ) { return table; }
+
+		// Loading is not an observable change, the table comes out the same
+		auto* self{ const_cast<ZealdocProvider*>( this ) };
+		table = self->load();
+
+		// The docsets went away since the constructor, serve nothing rather than crash
+		if ( !table ) { return empty; }
+
+		const QMutexLocker locker{ &m_tokensMutex };
+		self->m_tokens = table;
+	}
+
+	// Outside both locks, the budget takes the providers' locks when it evicts
+	m_budget->loaded( const_cast<ZealdocProvider*>( this ) );
+
+	return table;
+}
+
+const QHash<QString, int>& ZealdocProvider::priorities() const { return m_priorities; }
+
+const QStringList& ZealdocProvider::docsetPaths() const { return m_docsetPaths; }
+
+QString ZealdocProvider::docsetTitle( int entry ) const
+{
+	return m_docsetTitles.value( tokens()->entrySource( entry ) );
 }
 
-QStringList ZealdocProvider::groupTokens( const QString& group ) const
+const QStringList& ZealdocProvider::keywords() const { return m_keywords; }
+
+int ZealdocProvider::tokenCount() const { return m_tokenCount; }
+
+bool ZealdocProvider::isLoaded() const
 {
-	return m_groupTokens[group];
+	const QMutexLocker locker{ &m_tokensMutex };
+	return m_tokens != nullptr;
 }
+
+qint64 ZealdocProvider::memoryUsage() const
+{
+	const QMutexLocker locker{ &m_tokensMutex };
+	return m_tokens ? m_tokens->memoryUsage() : 0;
+}
+
+quint64 ZealdocProvider::lastUsed() const { return m_lastUsed; }
+
+void ZealdocProvider::unload()
+{
+	std::shared_ptr<const ZealTokenTable> dropped;
+
+	{
+		const QMutexLocker locker{ &m_tokensMutex };
+		dropped.swap( m_tokens );
+	}
+
+	// Freed here unless a caller still holds it, then by that caller
+}
+
+std::shared_ptr<const ZealTokenTable> ZealdocProvider::load()
+{
+	ZEAL_TRACE_SPAN( "provider", "ZealdocProvider::load" );
+
+	const bool firstLoad{ m_name.isEmpty() };
+
+	ZealTokenTable::Builder builder;
+	QStringList		titles;
+	QStringList		documentPaths;
+
+	std::vector<std::shared_ptr<Zeal::Registry::DocumentArchive>> archives;
+
+	// What each docset costs, for the config page
+	QVector<qint64> loadTimes;
+	QVector<int>	symbolCounts;
+	int		totalSymbols{ 0 };
+
+	for ( const QString& docsetPath : qAsConst( m_docsetPaths ) )
+	{
+		QElapsedTimer timer;
+		timer.start();
+
+		const Zeal::Registry::Docset ds{ docsetPath, m_profile };
+
+		if ( !ds.isValid() ) { continue; }
+
+		if ( firstLoad )
+		{
+			m_icon = ds.icon();
+
+			for ( const QString& keyword : ds.keywords() ) { m_keywords << keyword.toLower(); }
+		}
+
+		titles << ds.title();
+		documentPaths << ds.documentPath();
+
+		// The docset closes its archive when it goes, the URLs in the table need it open
+		if ( Zeal::Registry::DocumentArchive::isArchivePath( ds.documentPath() ) )
+		{
+			archives.push_back( Zeal::Registry::DocumentArchive::find( QUrl{ ds.documentPath() } ) );
+		}
+
+		builder.addSource( ds.documentPath(), m_priorities.value( ds.title() ) );
+
+		const QMap<QString, int> tokenGroups{ ds.symbolCounts() };
+		symbolCounts << 0;
+
+		for ( auto i = tokenGroups.cbegin(); i != tokenGroups.cend(); ++i )
+		{
+			const QString& groupName{ i.key() };
+
+			// Streamed, so neither the docset nor this provider keeps a map of URLs around
+			ds.forEachSymbol( groupName,
+					  [&]( const QString& token, const Zeal::Registry::Docset::PageLocation& location ) {
+						  builder.add( groupName, token, location );
+					  } );
+
+			symbolCounts.last() += i.value();
+		}
+
+		totalSymbols += symbolCounts.last();
+		loadTimes << timer.elapsed();
+	}
+
+	if ( titles.isEmpty() ) { return nullptr; }
+
+	if ( firstLoad )
+	{
+		m_docsetTitles	= titles;
+		m_documentPaths = documentPaths;
+		m_archives	= std::move( archives );
+
+		m_keywords.removeDuplicates();
+
+		if ( m_docsetPaths.size() > 1 )
+		{
+			m_name = i18n( "All Docsets" );
+			m_icon = QIcon::fromTheme( QStringLiteral( "zeal" ), m_icon );
+		}
+		else { m_name = titles.first(); }
+	}
+
+	QElapsedTimer buildTimer;
+	buildTimer.start();
+
+	auto table{ std::make_shared<const ZealTokenTable>( builder.build() ) };
+
+	// Docsets share the table, each is charged its share of the symbols
+	for ( int source = 0; source < titles.size(); ++source )
+	{
+		const double share{ totalSymbols > 0 ? double( symbolCounts.at( source ) ) / totalSymbols : 1.0 / titles.size() };
+
+		storeDocsetStats( titles.at( source ),
+				  { loadTimes.at( source ) + static_cast<qint64>( buildTimer.elapsed() * share ),
+				    static_cast<qint64>( table->memoryUsage() * share ) } );
+	}
+
+	return table;
+}
+
+QIcon ZealdocProvider::groupIcon( const QString& group )
+{
+	return QIcon::fromTheme( QStringLiteral( "zealdoc_%1" ).arg( group.toLower() ) );
+}
+
@@ -19,16 +19,37 @@
 
 #include <interfaces/idocumentationprovider.h>
 #include <interfaces/iplugin.h>
+#include <util/sqlitedatabase.h>
 
+#include <QHash>
 #include <QIcon>
-#include <QStringListModel>
+#include <QMutex>
 #include <QUrl>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "zealtokentable.h"
+
+class ZealDeclarationCache;
+class ZealFullTextIndex;
+class ZealIndexModel;
+class ZealMemoryBudget;
+class ZealSnippetIndex;
+
+namespace Zeal { namespace Registry {
+class DocumentArchive;
+}}
 
 /*!
  * \class ZealdocProvider
  * \brief The ZealdocProvider class provides documentation functionalities for KDevelop using Zeal docsets.
  *
  * This class implements the KDevelop::IDocumentationProvider interface to integrate with KDevelop's documentation system.
+ *
+ * A provider normally serves one docset. In aggregated mode a single provider serves
+ * all enabled docsets from one merged token table, so KDevelop probes one index
+ * instead of one per docset.
  */
 class ZealdocProvider
 	: public QObject
@@ -42,9 +63,34 @@ public:
 	/*!
 	 * \brief Constructs the ZealdocProvider with the specified docset path and parent object.
 	 * \param docsetPath The path to the docset.
+	 * \param cache The plugin's declaration cache, shared by all providers.
+	 * \param budget The plugin's memory budget, shared by all providers. The caller adds the provider to it.
+	 * \param snippets The plugin's hover snippet index, shared by all providers.
 	 * \param parent The parent QObject.
 	 */
-	ZealdocProvider( const QString& docsetPath, QObject* parent );
+	ZealdocProvider( const QString&	       docsetPath,
+			 ZealDeclarationCache* cache,
+			 ZealMemoryBudget*     budget,
+			 ZealSnippetIndex*     snippets,
+			 QObject*	       parent );
+
+	/*!
+	 * \brief Constructs a provider serving several docsets from one merged table.
+	 *
+	 * Tokens documented by more than one docset are resolved by the priorities from
+	 * docsetPriorities().
+	 *
+	 * \param docsetPaths The paths to the docsets.
+	 * \param cache The plugin's declaration cache, shared by all providers.
+	 * \param budget The plugin's memory budget, shared by all providers. The caller adds the provider to it.
+	 * \param snippets The plugin's hover snippet index, shared by all providers.
+	 * \param parent The parent QObject.
+	 */
+	ZealdocProvider( const QStringList&    docsetPaths,
+			 ZealDeclarationCache* cache,
+			 ZealMemoryBudget*     budget,
+			 ZealSnippetIndex*     snippets,
+			 QObject*	       parent );
 
 	/*!
 	 * \brief Destroys the ZealdocProvider.
@@ -105,6 +151,28 @@ public:
 	 */
 	[[nodiscard]] KDevelop::IDocumentation::Ptr documentationForToken( const QString& token ) const;
 
+	/*!
+	 * \brief Returns the documentation for an entry of the token table.
+	 * \param entry The entry, or -1.
+	 * \return The documentation pointer, null for -1.
+	 */
+	[[nodiscard]] KDevelop::IDocumentation::Ptr documentationForEntry( int entry ) const;
+
+	/*!
+	 * \brief Returns the documentation for a page found by its text.
+	 * \param title The page's title.
+	 * \param url The page's URL.
+	 * \return The documentation pointer.
+	 */
+	[[nodiscard]] KDevelop::IDocumentation::Ptr documentationForPage( const QString& title, const QUrl& url ) const;
+
+	/*!
+	 * \brief Returns the full-text index of the docsets' pages.
+	 *
+	 * The index is created and brought up to date in the background on the first call.
+	 */
+	[[nodiscard]] ZealFullTextIndex* fullTextIndex() const;
+
 	/*!
 	 * \brief Returns the index model for the documentation.
 	 * \return The index model pointer.
@@ -117,6 +185,66 @@ public:
 	 */
 	[[nodiscard]] QStringList tokenGroups() const;
 
+	/*!
+	 * \brief Returns the paths of the docsets this provider serves.
+	 */
+	[[nodiscard]] const QStringList& docsetPaths() const;
+
+	/*!
+	 * \brief Returns the title of the docset an entry of the token table comes from.
+	 */
+	[[nodiscard]] QString docsetTitle( int entry ) const;
+
+	/*!
+	 * \brief Returns the docset's keywords, lowercased.
+	 */
+	[[nodiscard]] const QStringList& keywords() const;
+
+	/*!
+	 * \brief Returns the table holding all tokens, their URLs and their groups.
+	 *
+	 * Rebuilds the table from the docset if the memory budget dropped it. The table
+	 * comes out the same every time, so rows and groups stay valid across rebuilds.
+	 *
+	 * Safe to call from any thread. The table stays valid for as long as the caller
+	 * holds on to it, even if the budget drops it from the provider meanwhile.
+	 *
+	 * \return The token table, never null.
+	 */
+	[[nodiscard]] std::shared_ptr<const ZealTokenTable> tokens() const;
+
+	/*!
+	 * \brief Returns the docset priorities the table was built with.
+	 */
+	[[nodiscard]] const QHash<QString, int>& priorities() const;
+
+	/*!
+	 * \brief Returns the number of tokens, without loading the table.
+	 */
+	[[nodiscard]] int tokenCount() const;
+
+	/*!
+	 * \brief Checks whether the token table is in memory.
+	 */
+	[[nodiscard]] bool isLoaded() const;
+
+	/*!
+	 * \brief Returns the memory used by the token table, 0 while it is not loaded.
+	 */
+	[[nodiscard]] qint64 memoryUsage() const;
+
+	/*!
+	 * \brief Returns the use stamp of the last access to the token table.
+	 */
+	[[nodiscard]] quint64 lastUsed() const;
+
+	/*!
+	 * \brief Drops the token table, it is rebuilt on the next access.
+	 *
+	 * Callers still holding the table keep using it until they let go.
+	 */
+	void unload();
+
 	/*!
 	 * \brief Returns the icon for the specified group.
 	 * \param group The group to get the icon for.
@@ -124,19 +252,35 @@ public:
 	 */
 	[[nodiscard]] QIcon groupIcon( const QString& group );
 
+private:
 	/*!
-	 * \brief Returns the list of tokens for the specified group.
-	 * \param group The group to get tokens for.
-	 * \return The list of tokens.
+	 * \brief Builds the token table from the docsets.
+	 *
+	 * The docsets' titles, keywords and archives are only taken on the first load, from the
+	 * constructor, so rebuilds on other threads leave them alone.
+	 *
+	 * \return The table, null if no docset could be opened.
 	 */
-	[[nodiscard]] QStringList groupTokens( const QString& group ) const;
+	std::shared_ptr<const ZealTokenTable> load();
 
-private:
-	bool		  m_isValid; /**< Indicates whether the provider is valid. */
-	QString		  m_name;    /**< The name of the provider. */
-	QIcon		  m_icon;    /**< The icon of the provider. */
-	QStringListModel* m_model;   /**< The index model. */
-	QStringList	  m_tokenGroups;	  /**< The list of token groups. */
-	QMap<QString, QStringList> m_groupTokens; /**< The map of group tokens. */
-	QMap<QString, QUrl>	   m_tokenUrls;	  /**< The map of token URLs. */
+	bool		m_isValid; /**< Indicates whether the provider is valid. */
+	QString		m_name;	   /**< The name of the provider. */
+	QIcon		m_icon;	   /**< The icon of the provider. */
+	QStringList	m_docsetPaths; /**< The docsets the table is built from. */
+	QStringList	m_docsetTitles; /**< Title per source of the table. */
+	QStringList	m_documentPaths; /**< Document path per source of the table. */
+	std::vector<std::shared_ptr<Zeal::Registry::DocumentArchive>> m_archives; /**< Keeps archived pages reachable. */
+	QStringList	m_keywords;   /**< The docset's keywords, lowercased, for routing. */
+	ZealIndexModel* m_model = nullptr; /**< The index model, a view over m_tokens. */
+	Zeal::Util::SQLiteDatabase::Profile m_profile; /**< Read once, rebuilds may run off the GUI thread. */
+	QHash<QString, int> m_priorities; /**< Read once, for the same reason. */
+	std::shared_ptr<const ZealTokenTable> m_tokens; /**< Tokens, their URLs and their groups, null while dropped. */
+	mutable QMutex	m_tokensMutex; /**< Guards m_tokens. */
+	mutable QMutex	m_loadMutex;   /**< Lets one thread rebuild m_tokens while the others wait. */
+	mutable std::atomic<quint64> m_lastUsed{ 0 }; /**< Use stamp of the last access to m_tokens. */
+	int		m_tokenCount = 0; /**< Size of m_tokens, kept while it is dropped. */
+	ZealDeclarationCache* m_cache; /**< Declarations already resolved, owned by the plugin. */
+	ZealMemoryBudget*     m_budget; /**< Decides when m_tokens is dropped, owned by the plugin. */
+	ZealSnippetIndex*     m_snippets; /**< Describes documentation entries, owned by the plugin. */
+	mutable ZealFullTextIndex* m_fullText = nullptr; /**< Created on first use. */
 };
@@ -22,17 +22,25 @@
 #include <documentation/standarddocumentationview.h>
 #include <interfaces/icore.h>
 #include <interfaces/idocumentationcontroller.h>
+#include <registry/documentarchive.h>
 
 #include <KLocalizedString>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QTimer>
 #include <QTreeView>
+#include <QVBoxLayout>
 
 #include "zealdocprovider.h"
+#include "zealfulltextindex.h"
+#include "zealsnippetindex.h"
 
 ZealdocProvider* ZealDocumentation::m_provider = nullptr;
 
-ZealDocumentation::ZealDocumentation( const QString& name, const QUrl& url )
+ZealDocumentation::ZealDocumentation( const QString& name, const QUrl& url, ZealSnippetIndex* snippets )
 	: m_name{ name }
 	, m_url{ url }
+	, m_snippets{ snippets }
 {}
 
 QWidget* ZealDocumentation::documentationWidget( KDevelop::DocumentationFindWidget* findWidget,
@@ -40,14 +48,25 @@ QWidget* ZealDocumentation::documentationWidget( KDevelop::DocumentationFindWidg
 {
 	KDevelop::StandardDocumentationView* view{
 		new KDevelop::StandardDocumentationView{ findWidget, parent } };
-	view->load( m_url );
+
+	// The view can't load archive URLs, see DocumentArchive
+	const bool archived{ m_url.scheme() == QLatin1String( Zeal::Registry::DocumentArchive::Scheme ) };
+
+	view->load( archived ? Zeal::Registry::DocumentArchive::localUrl( m_url ) : m_url );
 
 	return view;
 }
 
 QString ZealDocumentation::name() const { return m_name; }
 
-QString ZealDocumentation::description() const { return m_name; }
+QString ZealDocumentation::description() const
+{
+	const QString snippet{ m_snippets ? m_snippets->snippet( m_url ) : QString{} };
+
+	if ( snippet.isEmpty() ) { return m_name; }
+
+	return QStringLiteral( "<b>%1</b><p>%2</p>" ).arg( m_name.toHtmlEscaped(), snippet.toHtmlEscaped() );
+}
 
 KDevelop::IDocumentationProvider* ZealDocumentation::provider() const
 {
@@ -70,15 +89,80 @@ QWidget* ZealDocumentationHome::documentationWidget( KDevelop::DocumentationFind
 {
 	Q_UNUSED( findWidget );
 
-	QTreeView*	   contents{ new QTreeView{ parent } };
-	ZealContentsModel* model{ new ZealContentsModel{ contents } };
+	ZealdocProvider* provider{ ZealDocumentation::m_provider };
+
+	QWidget*	   page{ new QWidget{ parent } };
+	QVBoxLayout*	   layout{ new QVBoxLayout{ page } };
+	QLineEdit*	   search{ new QLineEdit{ page } };
+	QTreeView*	   contents{ new QTreeView{ page } };
+	QListWidget*	   results{ new QListWidget{ page } };
+	QTimer*		   debounce{ new QTimer{ page } };
+	ZealContentsModel* model{ new ZealContentsModel{ provider, contents } };
 
 	connect( contents, &QTreeView::clicked, model, &ZealContentsModel::showItem );
 
 	contents->setHeaderHidden( true );
 	contents->setModel( model );
 
-	return contents;
+	// Searching the text swaps the contents for the matching pages
+	search->setPlaceholderText( i18n( "Search the text of all pages" ) );
+	search->setClearButtonEnabled( true );
+	results->hide();
+
+	debounce->setSingleShot( true );
+	debounce->setInterval( 200 );
+
+	const auto showResults = [provider, search, contents, results] {
+		const QString query{ search->text().trimmed() };
+
+		contents->setVisible( query.isEmpty() );
+		results->setVisible( !query.isEmpty() );
+		results->clear();
+
+		if ( query.isEmpty() ) { return; }
+
+		const ZealFullTextIndex* index{ provider->fullTextIndex() };
+
+		if ( !index->isReady() )
+		{
+			results->addItem( i18n( "Indexing pages…" ) );
+			return;
+		}
+
+		const auto hits{ index->search( query ) };
+
+		if ( hits.isEmpty() ) { results->addItem( i18n( "No page mentions \"%1\"", query ) ); }
+
+		for ( const ZealFullTextIndex::Hit& hit : hits )
+		{
+			QListWidgetItem* item{ new QListWidgetItem{ hit.title, results } };
+			item->setData( Qt::UserRole, hit.url );
+			item->setToolTip( hit.url.toString( QUrl::PreferLocalFile ) );
+		}
+	};
+
+	connect( search, &QLineEdit::textChanged, debounce, qOverload<>( &QTimer::start ) );
+	connect( debounce, &QTimer::timeout, page, showResults );
+
+	// Opening the contents starts indexing, so it's likely done once a query is typed
+	connect( provider->fullTextIndex(), &ZealFullTextIndex::ready, page, showResults );
+
+	connect( results, &QListWidget::itemClicked, page, [provider]( QListWidgetItem* item ) {
+		const QUrl url{ item->data( Qt::UserRole ).toUrl() };
+
+		if ( url.isValid() )
+		{
+			KDevelop::ICore::self()->documentationController()->showDocumentation(
+				provider->documentationForPage( item->text(), url ) );
+		}
+	} );
+
+	layout->setContentsMargins( 0, 0, 0, 0 );
+	layout->addWidget( search );
+	layout->addWidget( contents );
+	layout->addWidget( results );
+
+	return page;
 }
 
 KDevelop::IDocumentationProvider* ZealDocumentationHome::provider() const
@@ -88,26 +172,32 @@ KDevelop::IDocumentationProvider* ZealDocumentationHome::provider() const
 
 // =================================================================================================
 
-ZealContentsModel::ZealContentsModel( QObject* parent )
+ZealContentsModel::ZealContentsModel( ZealdocProvider* provider, QObject* parent )
 	: QAbstractItemModel{ parent }
-{}
-
-int ZealContentsModel::rowCount( const QModelIndex& parent ) const
+	, m_provider{ provider }
 {
-	if ( !parent.isValid() )
+	const auto tokens{ m_provider->tokens() };
+
+	m_groups.reserve( tokens->groupNames().size() );
+
+	for ( int group = 0; group < tokens->groupNames().size(); ++group )
 	{
-		return ZealDocumentation::m_provider->tokenGroups().size();
+		const QString& name{ tokens->groupNames().at( group ) };
+		m_groups.push_back( { group, name, m_provider->groupIcon( name ), tokens->groupSize( group ) } );
 	}
+}
 
-	if ( static_cast<int>( parent.internalId() ) < 0 )
-	{
-		QString groupName{ parent.data( Qt::DisplayRole ).toString() };
+ZealContentsModel::GroupNode* ZealContentsModel::groupOf( const QModelIndex& index ) const
+{
+	return static_cast<GroupNode*>( index.internalPointer() );
+}
 
-		int groupSize =
-			ZealDocumentation::m_provider->groupTokens( groupName ).size();
+int ZealContentsModel::rowCount( const QModelIndex& parent ) const
+{
+	if ( !parent.isValid() ) { return static_cast<int>( m_groups.size() ); }
 
-		return groupSize;
-	}
+	// Only groups (top-level rows, without a node of their own) have children
+	if ( !groupOf( parent ) ) { return m_groups.at( parent.row() ).fetched; }
 
 	return 0;
 }
@@ -116,10 +206,9 @@ int ZealContentsModel::columnCount( const QModelIndex& ) const { return 1; }
 
 QModelIndex ZealContentsModel::parent( const QModelIndex& child ) const
 {
-	if ( child.isValid() && child.column() == 0 && int( child.internalId() ) >= 0 )
-	{
-		return createIndex( child.internalId(), 0, -1 );
-	}
+	const GroupNode* node{ child.isValid() ? groupOf( child ) : nullptr };
+
+	if ( node ) { return createIndex( node->group, 0, nullptr ); }
 
 	return QModelIndex{};
 }
@@ -128,47 +217,94 @@ QModelIndex ZealContentsModel::index( int row, int column, const QModelIndex& pa
 {
 	if ( row < 0 || column != 0 ) { return QModelIndex{}; }
 
-	if ( !parent.isValid() && row >= rowCount() ) { return QModelIndex{}; }
+	if ( !parent.isValid() )
+	{
+		if ( row >= static_cast<int>( m_groups.size() ) ) { return QModelIndex{}; }
+
+		return createIndex( row, column, nullptr );
+	}
 
-	return createIndex( row, column, parent.isValid() ? parent.row() : -1 );
+	if ( groupOf( parent ) || row >= m_groups.at( parent.row() ).fetched ) { return QModelIndex{}; }
+
+	// Nodes are never moved, so the pointer stays valid for the model's lifetime
+	return createIndex( row, column, const_cast<GroupNode*>( &m_groups.at( parent.row() ) ) );
 }
 
 QVariant ZealContentsModel::data( const QModelIndex& index, int role ) const
 {
 	if ( index.isValid() )
 	{
-		const int internal = index.internalId();
-		QString	  groupName;
+		const GroupNode* node{ groupOf( index ) };
 
-		if ( internal < 0 )
+		if ( !node )
 		{
-			groupName = ZealDocumentation::m_provider->tokenGroups().at(
-				index.row() );
+			// A group
+			const GroupNode& group{ m_groups.at( index.row() ) };
+
+			if ( role == Qt::DisplayRole ) { return group.name; }
+
+			if ( role == Qt::DecorationRole ) { return group.icon; }
+
+			return {};
 		}
-		else { groupName = index.parent().data( Qt::DisplayRole ).toString(); }
 
 		if ( role == Qt::DisplayRole )
 		{
-			if ( internal < 0 ) { return groupName; }
+			const auto tokens{ m_provider->tokens() };
 
-			return ZealDocumentation::m_provider->groupTokens( groupName ).at( index.row() );
-		}
+			if ( index.row() < tokens->groupSize( node->group ) )
+			{
+				return tokens->tokenString( tokens->groupToken( node->group, index.row() ) );
+			}
 
-		if ( role == Qt::DecorationRole )
-		{
-			return ZealDocumentation::m_provider->groupIcon( groupName );
+			return {};
 		}
+
+		if ( role == Qt::DecorationRole ) { return node->icon; }
 	}
 
 	return {};
 }
 
+bool ZealContentsModel::canFetchMore( const QModelIndex& parent ) const
+{
+	if ( !parent.isValid() || groupOf( parent ) ) { return false; }
+
+	const GroupNode& group{ m_groups.at( parent.row() ) };
+	return group.fetched < group.size;
+}
+
+void ZealContentsModel::fetchMore( const QModelIndex& parent )
+{
+	if ( !canFetchMore( parent ) ) { return; }
+
+	GroupNode& group{ m_groups.at( parent.row() ) };
+	const int  count{ qMin( BatchSize, group.size - group.fetched ) };
+
+	beginInsertRows( parent, group.fetched, group.fetched + count - 1 );
+	group.fetched += count;
+	endInsertRows();
+}
+
+bool ZealContentsModel::hasChildren( const QModelIndex& parent ) const
+{
+	if ( !parent.isValid() ) { return !m_groups.empty(); }
+
+	return !groupOf( parent ) && m_groups.at( parent.row() ).size > 0;
+}
+
 void ZealContentsModel::showItem( const QModelIndex& idx )
 {
-	if ( idx.isValid() && int( idx.internalId() ) >= 0 )
+	const GroupNode* node{ idx.isValid() ? groupOf( idx ) : nullptr };
+
+	if ( !node ) { return; }
+
+	const auto tokens{ m_provider->tokens() };
+
+	if ( idx.row() < tokens->groupSize( node->group ) )
 	{
-		auto doc = ZealDocumentation::m_provider->documentationForToken(
-			idx.data( Qt::DisplayRole ).toString() );
+		// The entry of this group, a token documented in several groups has one per group
+		auto doc = m_provider->documentationForEntry( tokens->groupEntry( node->group, idx.row() ) );
 		KDevelop::ICore::self()->documentationController()->showDocumentation( doc );
 	}
 }
@@ -22,9 +22,12 @@
 #include <interfaces/idocumentation.h>
 
 #include <QAbstractItemModel>
+#include <QIcon>
 #include <QUrl>
+#include <vector>
 
 class ZealdocProvider;
+class ZealSnippetIndex;
 
 /*!
  * \class ZealDocumentation
@@ -42,8 +45,9 @@ public:
 	 * \brief Constructs a ZealDocumentation object with the specified name and URL.
 	 * \param name The name of the documentation entry.
 	 * \param url The URL of the documentation entry.
+	 * \param snippets Extracts the description from the page, may be null.
 	 */
-	ZealDocumentation( const QString& name, const QUrl& url );
+	ZealDocumentation( const QString& name, const QUrl& url, ZealSnippetIndex* snippets = nullptr );
 
 	/*!
 	 * \brief Returns the name of the documentation entry.
@@ -53,6 +57,10 @@ public:
 
 	/*!
 	 * \brief Returns a description of the documentation entry.
+	 *
+	 * This is shown in hover tooltips: the entry's name followed by the first
+	 * paragraph documented under its anchor, when there is one.
+	 *
 	 * \return The description of the documentation entry.
 	 */
 	QString description() const override;
@@ -77,6 +85,7 @@ public:
 private:
 	QString m_name; /*!< The name of the documentation entry. */
 	QUrl	m_url;	/*!< The URL of the documentation entry. */
+	ZealSnippetIndex* m_snippets; /*!< Owned by the plugin. */
 };
 
 /*!
@@ -129,6 +138,11 @@ public:
  *
  * This class is responsible for managing the data and structure of the content
  * tree view used in the Zeal documentation.
+ *
+ * Groups are the top-level rows and tokens their children. Every child points to
+ * its group's node through the internal pointer, so no lookup goes by name. Group
+ * names and icons are resolved once, and the tokens of a group are exposed in
+ * batches through canFetchMore()/fetchMore().
  */
 class ZealContentsModel: public QAbstractItemModel
 {
@@ -137,9 +151,10 @@ class ZealContentsModel: public QAbstractItemModel
 public:
 	/*!
 	 * \brief Constructs a ZealContentsModel object with the specified parent.
+	 * \param provider The provider whose contents are shown.
 	 * \param parent The parent object.
 	 */
-	ZealContentsModel( QObject* parent );
+	ZealContentsModel( ZealdocProvider* provider, QObject* parent );
 
 	/*!
 	 * \brief Returns the number of rows under the given parent.
@@ -181,10 +196,56 @@ public:
 	 */
 	[[nodiscard]] QVariant data( const QModelIndex& index, int role ) const override;
 
+	/*!
+	 * \brief Checks whether a group has tokens that are not exposed as rows yet.
+	 * \param parent The index of the group.
+	 * \return True if fetchMore() would add rows.
+	 */
+	[[nodiscard]] bool canFetchMore( const QModelIndex& parent ) const override;
+
+	/*!
+	 * \brief Exposes the next batch of tokens of a group.
+	 * \param parent The index of the group.
+	 */
+	void fetchMore( const QModelIndex& parent ) override;
+
+	/*!
+	 * \brief Reports groups as expandable before any of their rows are fetched.
+	 * \param parent The parent index.
+	 * \return True if \a parent has or can fetch children.
+	 */
+	[[nodiscard]] bool hasChildren( const QModelIndex& parent = QModelIndex() ) const override;
+
 public Q_SLOTS:
 	/*!
 	 * \brief Shows the item referred to by the index.
 	 * \param idx The index of the item to show.
 	 */
 	void showItem( const QModelIndex& idx );
+
+private:
+	/*!
+	 * \brief A top-level row. Children keep a pointer to it as their internal pointer.
+	 */
+	struct GroupNode
+	{
+		int	group;	      /*!< The group's index in the token table. */
+		QString name;	      /*!< The group's name. */
+		QIcon	icon;	      /*!< The group's icon, looked up once. */
+		int	size;	      /*!< The number of tokens in the group. */
+		int	fetched = 0;  /*!< The number of tokens exposed as rows. */
+	};
+
+	/*!
+	 * \brief Returns the group node a child index points to, or nullptr for groups.
+	 */
+	GroupNode* groupOf( const QModelIndex& index ) const;
+
+	/*!
+	 * \brief The number of tokens a single fetchMore() adds to a group.
+	 */
+	static constexpr int BatchSize = 512;
+
+	ZealdocProvider*       m_provider; /*!< The provider this model shows. */
+	std::vector<GroupNode> m_groups;   /*!< One node per group, never resized. */
 };
@@ -0,0 +1,605 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "zealfulltextindex.h"
+
+#include <registry/docset.h>
+#include <registry/documentarchive.h>
+#include <util/trace.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+struct ZealFullTextIndex::Data
+{
+	struct Page
+	{
+		quint16 source;	      /*!< Index in documentPaths. */
+		QString path;	      /*!< Relative to its document path. */
+		QString title;
+		qint64	modified;     /*!< To tell whether the page changed, ms since epoch. */
+		qint64	size;
+		quint32 length;	      /*!< Number of words. */
+	};
+
+	QStringList	 documentPaths;
+	QVector<Page>	 pages;
+	QStringList	 terms;		    /*!< Sorted. */
+	QVector<quint32> offsets;	    /*!< Postings of terms[i] are [offsets[i], offsets[i + 1]). */
+	QVector<quint32> postingPages;	    /*!< Ascending per term. */
+	QVector<quint16> postingCounts;	    /*!< Occurrences of the term on the page. */
+	double		 averageLength = 0;
+};
+
+namespace {
+constexpr quint32 SidecarMagic{ 0x5a465449 };	 // "ZFTI"
+constexpr quint32 SidecarVersion{ 1 };
+constexpr int	  MinTermLength{ 2 };
+constexpr int	  MaxTermLength{ 40 };
+constexpr int	  MaxPrefixTerms{ 64 };	   // Terms a prefix may expand to
+constexpr double  K1{ 1.2 };		   // BM25 parameters
+constexpr double  B{ 0.75 };
+
+struct PageStamp
+{
+	quint16 source;
+	QString path;
+	qint64	modified;
+	qint64	size;
+};
+
+struct Extracted
+{
+	QString			title;
+	QHash<QString, quint16> counts;
+	quint32			length = 0;
+};
+
+bool isPage( const QString& path )
+{
+	return path.endsWith( QLatin1String( ".html" ), Qt::CaseInsensitive )
+	       || path.endsWith( QLatin1String( ".htm" ), Qt::CaseInsensitive );
+}
+
+/*!
+ * \brief Calls \a f with every lowercased word of \a text.
+ */
+void tokenize( const QString& text, const std::function<void( const QString& )>& f )
+{
+	QString word;
+
+	const auto flush = [&] {
+		if ( word.size() >= MinTermLength && word.size() <= MaxTermLength ) { f( word ); }
+		word.clear();
+	};
+
+	for ( const QChar c : text )
+	{
+		if ( c.isLetterOrNumber() || c == QLatin1Char( '_' ) ) { word += c.toLower(); }
+		else { flush(); }
+	}
+
+	flush();
+}
+
+/*!
+ * \brief Finds \a needle in \a haystack from \a from on, ignoring ASCII case.
+ */
+int indexOfTag( const QByteArray& haystack, int from, const char* needle )
+{
+	const int length{ static_cast<int>( std::strlen( needle ) ) };
+
+	for ( int i = from; i + length <= haystack.size(); ++i )
+	{
+		i = haystack.indexOf( '<', i );
+
+		if ( i < 0 || i + length > haystack.size() ) { break; }
+
+		if ( qstrnicmp( haystack.constData() + i, needle, length ) == 0 ) { return i; }
+	}
+
+	return -1;
+}
+
+/*!
+ * \brief Returns the title and the words of the page \a html.
+ */
+Extracted extract( const QByteArray& html )
+{
+	Extracted  result;
+	QByteArray text;
+	text.reserve( html.size() / 2 );
+
+	for ( int i = 0; i < html.size(); )
+	{
+		const char c{ html.at( i ) };
+
+		if ( c == '&' )
+		{
+			// Entities only separate words here
+			const int end{ html.indexOf( ';', i ) };
+			i = end > i && end - i < 10 ? end + 1 : i + 1;
+			text += ' ';
+			continue;
+		}
+
+		if ( c != '<' )
+		{
+			text += c;
+			++i;
+			continue;
+		}
+
+		if ( qstrncmp( html.constData() + i, "<!--", 4 ) == 0 )
+		{
+			const int end{ html.indexOf( "-->", i + 4 ) };
+			i = end < 0 ? html.size() : end + 3;
+			continue;
+		}
+
+		const char* tag{ html.constData() + i + 1 };
+		const char* skipTo{ nullptr };
+
+		if ( qstrnicmp( tag, "script", 6 ) == 0 ) { skipTo = "</script"; }
+		else if ( qstrnicmp( tag, "style", 5 ) == 0 ) { skipTo = "</style"; }
+		else if ( qstrnicmp( tag, "title", 5 ) == 0 && result.title.isEmpty() )
+		{
+			const int start{ html.indexOf( '>', i ) + 1 };
+			const int end{ start > 0 ? indexOfTag( html, start, "</title" ) : -1 };
+
+			if ( end > start )
+			{
+				result.title = QString::fromUtf8( html.mid( start, end - start ) ).simplified();
+			}
+		}
+
+		if ( skipTo )
+		{
+			const int end{ indexOfTag( html, i + 1, skipTo ) };
+			i = end < 0 ? html.size() : end;
+		}
+
+		const int end{ html.indexOf( '>', i ) };
+		i = end < 0 ? html.size() : end + 1;
+		text += ' ';
+	}
+
+	tokenize( QString::fromUtf8( text ), [&]( const QString& word ) {
+		quint16& count{ result.counts[word] };
+
+		if ( count < 0xffff ) { ++count; }
+
+		++result.length;
+	} );
+
+	return result;
+}
+
+struct ExtractJob
+{
+	PageStamp stamp;
+	Extracted result;
+};
+}    // namespace
+
+ZealFullTextIndex::ZealFullTextIndex( const QStringList& documentPaths, QObject* parent )
+	: QObject{ parent }
+	, m_documentPaths{ documentPaths }
+{
+	const QByteArray key{ QCryptographicHash::hash( documentPaths.join( QLatin1Char( '\n' ) ).toUtf8(),
+							QCryptographicHash::Sha1 )
+				      .toHex() };
+
+	m_sidecarPath = QStandardPaths::writableLocation( QStandardPaths::CacheLocation )
+			+ QStringLiteral( "/fulltext/%1.idx" ).arg( QString::fromLatin1( key ) );
+
+	connect( &m_watcher, &QFutureWatcher<std::shared_ptr<const Data>>::finished, this, [this] {
+		const std::shared_ptr<const Data> data{ m_watcher.result() };
+
+		if ( !data ) { return; }
+
+		{
+			const QMutexLocker locker{ &m_mutex };
+			m_data = data;
+		}
+
+		Q_EMIT ready();
+	} );
+}
+
+ZealFullTextIndex::~ZealFullTextIndex()
+{
+	m_token.cancel();
+	m_watcher.waitForFinished();
+}
+
+void ZealFullTextIndex::update()
+{
+	if ( isUpdating() ) { return; }
+
+	std::shared_ptr<const Data> previous;
+
+	{
+		const QMutexLocker locker{ &m_mutex };
+		previous = m_data;
+	}
+
+	m_watcher.setFuture( QtConcurrent::run(
+		[paths = m_documentPaths, sidecar = m_sidecarPath, previous, token = m_token] {
+			return build( paths, sidecar, previous, token );
+		} ) );
+}
+
+bool ZealFullTextIndex::isReady() const
+{
+	const QMutexLocker locker{ &m_mutex };
+	return m_data != nullptr;
+}
+
+bool ZealFullTextIndex::isUpdating() const { return m_watcher.isRunning(); }
+
+QVector<ZealFullTextIndex::Hit> ZealFullTextIndex::search( const QString& query, int limit ) const
+{
+	ZEAL_TRACE_SPAN( "fulltext", "ZealFullTextIndex::search" );
+
+	std::shared_ptr<const Data> data;
+
+	{
+		const QMutexLocker locker{ &m_mutex };
+		data = m_data;
+	}
+
+	QStringList words;
+	tokenize( query, [&]( const QString& word ) { words << word; } );
+	words.removeDuplicates();
+
+	if ( !data || words.isEmpty() || data->pages.isEmpty() ) { return {}; }
+
+	const std::size_t   pageCount{ static_cast<std::size_t>( data->pages.size() ) };
+	std::vector<double> scores( pageCount, 0.0 );
+	std::vector<int>    matched( pageCount, 0 );    // Words found on the page
+	std::vector<int>    lastWord( pageCount, -1 );
+
+	for ( int w = 0; w < words.size(); ++w )
+	{
+		const QString& word{ words.at( w ) };
+		const bool     prefix{ w == words.size() - 1 };
+
+		auto       term{ std::lower_bound( data->terms.cbegin(), data->terms.cend(), word ) };
+		const auto first{ term };
+
+		for ( ; term != data->terms.cend(); ++term )
+		{
+			if ( prefix ? ( !term->startsWith( word ) || term - first >= MaxPrefixTerms ) : *term != word ) { break; }
+
+			const int     t{ static_cast<int>( term - data->terms.cbegin() ) };
+			const quint32 begin{ data->offsets.at( t ) };
+			const quint32 end{ data->offsets.at( t + 1 ) };
+			const double  idf{ std::log( 1.0 + ( pageCount - ( end - begin ) + 0.5 ) / ( end - begin + 0.5 ) ) };
+
+			for ( quint32 p = begin; p < end; ++p )
+			{
+				const quint32 page{ data->postingPages.at( p ) };
+				const double  tf{ static_cast<double>( data->postingCounts.at( p ) ) };
+				const double  norm{ 1.0 - B + B * data->pages.at( page ).length / data->averageLength };
+
+				scores[page] += idf * tf * ( K1 + 1.0 ) / ( tf + K1 * norm );
+
+				if ( lastWord[page] != w )
+				{
+					lastWord[page] = w;
+					++matched[page];
+				}
+			}
+		}
+	}
+
+	std::vector<quint32> pages;
+
+	for ( std::size_t page = 0; page < pageCount; ++page )
+	{
+		if ( matched[page] == words.size() ) { pages.push_back( static_cast<quint32>( page ) ); }
+	}
+
+	const auto best{ pages.begin() + std::min<std::size_t>( pages.size(), qMax( 0, limit ) ) };
+	std::partial_sort( pages.begin(), best, pages.end(),
+			   [&]( quint32 a, quint32 b ) { return scores[a] > scores[b]; } );
+
+	QVector<Hit> hits;
+	hits.reserve( static_cast<int>( best - pages.begin() ) );
+
+	for ( auto it = pages.begin(); it != best; ++it )
+	{
+		const Data::Page& page{ data->pages.at( *it ) };
+
+		hits.append( { page.title,
+			       Zeal::Registry::Docset::pageUrl( data->documentPaths.at( page.source ),
+							     Zeal::Registry::Docset::PageLocation{ page.path } ),
+			       static_cast<int>( scores[*it] * 100 ) } );
+	}
+
+	return hits;
+}
+
+std::shared_ptr<const ZealFullTextIndex::Data> ZealFullTextIndex::build(
+	const QStringList&			 documentPaths,
+	const QString&				 sidecarPath,
+	std::shared_ptr<const Data>		 previous,
+	const Zeal::Registry::CancellationToken& token )
+{
+	ZEAL_TRACE_SPAN( "fulltext", "ZealFullTextIndex::build" );
+
+	const bool fromSidecar{ !previous };
+
+	if ( !previous ) { previous = load( sidecarPath, documentPaths ); }
+
+	// List the pages, with what tells whether they changed
+	QVector<PageStamp> stamps;
+
+	for ( int source = 0; source < documentPaths.size(); ++source )
+	{
+		const QString& documentPath{ documentPaths.at( source ) };
+
+		if ( Zeal::Registry::DocumentArchive::isArchivePath( documentPath ) )
+		{
+			const auto archive{ Zeal::Registry::DocumentArchive::find( QUrl{ documentPath } ) };
+
+			if ( !archive ) { continue; }
+
+			archive->forEachDocument( [&]( const QString& path, qint64 modified, qint64 size ) {
+				if ( isPage( path ) ) { stamps.append( { static_cast<quint16>( source ), path, modified, size } ); }
+			} );
+
+			continue;
+		}
+
+		const QDir   dir{ documentPath };
+		QDirIterator it{ documentPath, { QStringLiteral( "*.html" ), QStringLiteral( "*.htm" ) }, QDir::Files,
+				 QDirIterator::Subdirectories };
+
+		while ( it.hasNext() )
+		{
+			it.next();
+
+			const QFileInfo info{ it.fileInfo() };
+			stamps.append( { static_cast<quint16>( source ), dir.relativeFilePath( info.filePath() ),
+					 info.lastModified().toMSecsSinceEpoch(), info.size() } );
+		}
+	}
+
+	if ( token.isCanceled() ) { return nullptr; }
+
+	// Keep the pages that didn't change, only the others are read again
+	QHash<QPair<quint16, QString>, int> previousPages;
+
+	if ( previous )
+	{
+		for ( int page = 0; page < previous->pages.size(); ++page )
+		{
+			previousPages.insert( { previous->pages.at( page ).source, previous->pages.at( page ).path }, page );
+		}
+	}
+
+	auto data{ std::make_shared<Data>() };
+	data->documentPaths = documentPaths;
+
+	QVector<qint32>	    remap( previous ? previous->pages.size() : 0, -1 );
+	QVector<ExtractJob> changed;
+
+	for ( const PageStamp& stamp : qAsConst( stamps ) )
+	{
+		const int page{ previousPages.value( { stamp.source, stamp.path }, -1 ) };
+
+		if ( page >= 0 && previous->pages.at( page ).modified == stamp.modified
+		     && previous->pages.at( page ).size == stamp.size )
+		{
+			remap[page] = data->pages.size();
+			data->pages.append( previous->pages.at( page ) );
+		}
+		else { changed.append( { stamp, {} } ); }
+	}
+
+	if ( previous && changed.isEmpty() && data->pages.size() == previous->pages.size() )
+	{
+		qDebug() << "Full-text index up to date:" << sidecarPath;
+		return previous;
+	}
+
+	// Strip and tokenize the changed pages on all cores
+	QtConcurrent::blockingMap( changed, [&]( ExtractJob& job ) {
+		if ( token.isCanceled() ) { return; }
+
+		const PageStamp& stamp{ job.stamp };
+		const QString&	 documentPath{ documentPaths.at( stamp.source ) };
+		QByteArray	 html;
+
+		if ( Zeal::Registry::DocumentArchive::isArchivePath( documentPath ) )
+		{
+			if ( const auto archive{ Zeal::Registry::DocumentArchive::find( QUrl{ documentPath } ) } )
+			{
+				html = archive->inflate( stamp.path );
+			}
+		}
+		else
+		{
+			QFile file{ QDir( documentPath ).absoluteFilePath( stamp.path ) };
+
+			if ( file.open( QIODevice::ReadOnly ) ) { html = file.readAll(); }
+		}
+
+		job.result = extract( html );
+	} );
+
+	if ( token.isCanceled() ) { return nullptr; }
+
+	// Merge the postings of kept pages with the new ones
+	QHash<QString, QVector<QPair<quint32, quint16>>> postings;
+
+	if ( previous )
+	{
+		for ( int t = 0; t < previous->terms.size(); ++t )
+		{
+			for ( quint32 p = previous->offsets.at( t ); p < previous->offsets.at( t + 1 ); ++p )
+			{
+				const qint32 page{ remap.at( previous->postingPages.at( p ) ) };
+
+				if ( page >= 0 )
+				{
+					postings[previous->terms.at( t )].append(
+						{ static_cast<quint32>( page ), previous->postingCounts.at( p ) } );
+				}
+			}
+		}
+	}
+
+	for ( int i = 0; i < changed.size(); ++i )
+	{
+		const PageStamp& stamp{ changed.at( i ).stamp };
+		const Extracted& page{ changed.at( i ).result };
+		const quint32	 id{ static_cast<quint32>( data->pages.size() ) };
+
+		data->pages.append( { stamp.source, stamp.path,
+				      page.title.isEmpty() ? QFileInfo( stamp.path ).completeBaseName() : page.title,
+				      stamp.modified, stamp.size, page.length } );
+
+		for ( auto it = page.counts.cbegin(); it != page.counts.cend(); ++it )
+		{
+			postings[it.key()].append( { id, it.value() } );
+		}
+	}
+
+	data->terms = postings.keys();
+	std::sort( data->terms.begin(), data->terms.end() );
+
+	data->offsets.reserve( data->terms.size() + 1 );
+
+	for ( const QString& term : qAsConst( data->terms ) )
+	{
+		QVector<QPair<quint32, quint16>>& list{ postings[term] };
+		std::sort( list.begin(), list.end() );
+
+		data->offsets.append( data->postingPages.size() );
+
+		for ( const auto& posting : qAsConst( list ) )
+		{
+			data->postingPages.append( posting.first );
+			data->postingCounts.append( posting.second );
+		}
+	}
+
+	data->offsets.append( data->postingPages.size() );
+
+	quint64 words{ 0 };
+
+	for ( const Data::Page& page : qAsConst( data->pages ) ) { words += page.length; }
+
+	data->averageLength = data->pages.isEmpty() ? 1.0 : qMax( 1.0, double( words ) / data->pages.size() );
+
+	qDebug() << "Full-text index of" << data->pages.size() << "pages," << changed.size() << "read again,"
+		 << data->terms.size() << "terms" << ( fromSidecar ? "" : "(update)" );
+
+	if ( !save( *data, sidecarPath ) ) { qWarning() << "Can't save the full-text index" << sidecarPath; }
+
+	return data;
+}
+
+std::shared_ptr<const ZealFullTextIndex::Data> ZealFullTextIndex::load( const QString&	   sidecarPath,
+									 const QStringList& documentPaths )
+{
+	QFile file{ sidecarPath };
+
+	if ( !file.open( QIODevice::ReadOnly ) ) { return nullptr; }
+
+	QDataStream in{ &file };
+	in.setVersion( QDataStream::Qt_5_6 );
+
+	quint32 magic{ 0 };
+	quint32 version{ 0 };
+	in >> magic >> version;
+
+	if ( magic != SidecarMagic || version != SidecarVersion ) { return nullptr; }
+
+	auto data{ std::make_shared<Data>() };
+	int  pageCount{ 0 };
+	in >> data->documentPaths >> pageCount;
+
+	for ( int i = 0; i < pageCount && in.status() == QDataStream::Ok; ++i )
+	{
+		Data::Page page;
+		in >> page.source >> page.path >> page.title >> page.modified >> page.size >> page.length;
+		data->pages.append( page );
+	}
+
+	in >> data->terms >> data->offsets >> data->postingPages >> data->postingCounts >> data->averageLength;
+
+	// A damaged file would index out of bounds later
+	if ( in.status() != QDataStream::Ok || data->documentPaths != documentPaths
+	     || data->offsets.size() != data->terms.size() + 1 || data->postingPages.size() != data->postingCounts.size()
+	     || ( !data->offsets.isEmpty() && data->offsets.last() != static_cast<quint32>( data->postingPages.size() ) )
+	     || std::any_of( data->postingPages.cbegin(), data->postingPages.cend(),
+			     [&]( quint32 page ) { return page >= static_cast<quint32>( data->pages.size() ); } )
+	     || std::any_of( data->pages.cbegin(), data->pages.cend(),
+			     [&]( const Data::Page& page ) { return page.source >= documentPaths.size(); } ) )
+	{
+		return nullptr;
+	}
+
+	return data;
+}
+
+bool ZealFullTextIndex::save( const Data& data, const QString& sidecarPath )
+{
+	if ( !QDir{}.mkpath( QFileInfo( sidecarPath ).absolutePath() ) ) { return false; }
+
+	// Written aside and renamed, so a crash never leaves half an index behind
+	QSaveFile file{ sidecarPath };
+
+	if ( !file.open( QIODevice::WriteOnly ) ) { return false; }
+
+	QDataStream out{ &file };
+	out.setVersion( QDataStream::Qt_5_6 );
+
+	out << SidecarMagic << SidecarVersion << data.documentPaths << data.pages.size();
+
+	for ( const Data::Page& page : data.pages )
+	{
+		out << page.source << page.path << page.title << page.modified << page.size << page.length;
+	}
+
+	out << data.terms << data.offsets << data.postingPages << data.postingCounts << data.averageLength;
+
+	return out.status() == QDataStream::Ok && file.commit();
+}
@@ -0,0 +1,141 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#pragma once
+
+#include <registry/cancellationtoken.h>
+
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+#include <memory>
+
+/*!
+ * \class ZealFullTextIndex
+ * \brief An inverted index over the text of a provider's documentation pages.
+ *
+ * Symbol search only knows the names in the docsets' indexes. This index knows the
+ * words of every page, so "thread-safe" finds the pages that talk about it.
+ *
+ * Building runs in the background: pages are listed, the changed ones are stripped
+ * of their markup and tokenized in parallel, and their postings are merged with the
+ * ones of unchanged pages from the previous index. The result is saved in a sidecar
+ * file in the cache directory, so the next session only reads what changed since.
+ *
+ * Queries match pages holding all their words, the last one as a prefix since it
+ * is usually still being typed, and rank them with BM25.
+ */
+class ZealFullTextIndex: public QObject
+{
+	Q_OBJECT
+	Q_DISABLE_COPY_MOVE( ZealFullTextIndex )
+
+public:
+	/*!
+	 * \struct Hit
+	 * \brief A page matching a query.
+	 */
+	struct Hit
+	{
+		QString title;	  /*!< The page's title, or its file name. */
+		QUrl	url;	  /*!< Where the page is. */
+		int	score;	  /*!< Higher is better. */
+	};
+
+	/*!
+	 * \brief Constructs an index over the pages below \a documentPaths.
+	 *
+	 * Nothing is read until update() is called.
+	 *
+	 * \param documentPaths The document paths of the indexed docsets, see
+	 *        Zeal::Registry::Docset::documentPath().
+	 * \param parent The parent QObject.
+	 */
+	explicit ZealFullTextIndex( const QStringList& documentPaths, QObject* parent = nullptr );
+
+	/*!
+	 * \brief Cancels a running build and waits for it.
+	 */
+	~ZealFullTextIndex() override;
+
+	/*!
+	 * \brief Brings the index up to date with the pages in the background.
+	 *
+	 * Does nothing while a build is running. ready() is emitted when it is done.
+	 */
+	void update();
+
+	/*!
+	 * \brief Checks whether a built index is available to search().
+	 */
+	[[nodiscard]] bool isReady() const;
+
+	/*!
+	 * \brief Checks whether a build is running.
+	 */
+	[[nodiscard]] bool isUpdating() const;
+
+	/*!
+	 * \brief Returns the pages matching \a query, best first.
+	 * \param query Words to look for, case-insensitive.
+	 * \param limit The maximum number of pages to return.
+	 * \return The matching pages, none while the index isn't ready.
+	 */
+	[[nodiscard]] QVector<Hit> search( const QString& query, int limit = 50 ) const;
+
+Q_SIGNALS:
+	/*!
+	 * \brief Emitted when a build finished and search() uses its result.
+	 */
+	void ready();
+
+private:
+	struct Data;
+
+	/*!
+	 * \brief Builds the index, reusing the postings of unchanged pages in \a previous.
+	 */
+	static std::shared_ptr<const Data> build( const QStringList&				 documentPaths,
+						  const QString&				 sidecarPath,
+						  std::shared_ptr<const Data>			 previous,
+						  const Zeal::Registry::CancellationToken& token );
+
+	/*!
+	 * \brief Reads a saved index, null if there is none or it is unusable.
+	 */
+	static std::shared_ptr<const Data> load( const QString& sidecarPath, const QStringList& documentPaths );
+
+	/*!
+	 * \brief Saves \a data to \a sidecarPath.
+	 */
+	static bool save( const Data& data, const QString& sidecarPath );
+
+	QStringList				     m_documentPaths;
+	QString					     m_sidecarPath;
+	Zeal::Registry::CancellationToken	     m_token;
+	QFutureWatcher<std::shared_ptr<const Data>> m_watcher;
+	mutable QMutex				     m_mutex;	 /*!< Guards m_data. */
+	std::shared_ptr<const Data>		     m_data;	 /*!< The index queries use. */
+};
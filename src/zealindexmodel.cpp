@@ -0,0 +1,52 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "zealindexmodel.h"
+
+#include "zealdocprovider.h"
+
+ZealIndexModel::ZealIndexModel( const ZealdocProvider* provider, QObject* parent )
+	: QAbstractListModel{ parent }
+	, m_provider{ provider }
+{}
+
+int ZealIndexModel::rowCount( const QModelIndex& parent ) const
+{
+	if ( parent.isValid() ) { return 0; }
+
+	return m_provider->tokenCount();
+}
+
+QVariant ZealIndexModel::data( const QModelIndex& index, int role ) const
+{
+	if ( !index.isValid() ) { return {}; }
+
+	if ( role == Qt::DisplayRole )
+	{
+		const auto tokens{ m_provider->tokens() };
+
+		// Guards against a docset that changed on disk before a rebuild
+		if ( index.row() < tokens->size() ) { return tokens->tokenString( index.row() ); }
+	}
+
+	return {};
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#pragma once
+
+#include <QAbstractListModel>
+
+class ZealdocProvider;
+
+/*!
+ * \class ZealIndexModel
+ * \brief The documentation index of a provider, served from its token table.
+ *
+ * Rows are the table's tokens in order. Nothing is copied into the model, the
+ * display strings are created from the arena when a view asks for them. The row
+ * count comes from the provider, so a table dropped by the memory budget is only
+ * rebuilt once a row is actually read.
+ *
+ * All rows are exposed at once. KDevelop's documentation completer filters the model
+ * without ever calling fetchMore(), so paging would hide every token past the first page.
+ */
+class ZealIndexModel: public QAbstractListModel
+{
+	Q_OBJECT
+	Q_DISABLE_COPY_MOVE( ZealIndexModel )
+
+public:
+	/*!
+	 * \brief Constructs the model over the tokens of \a provider, which must outlive it.
+	 * \param provider The provider whose tokens are shown.
+	 * \param parent The parent object.
+	 */
+	ZealIndexModel( const ZealdocProvider* provider, QObject* parent );
+
+	/*!
+	 * \brief Returns the number of tokens.
+	 * \param parent The parent index, rows only exist at the top level.
+	 * \return The number of rows under \a parent.
+	 */
+	[[nodiscard]] int rowCount( const QModelIndex& parent = QModelIndex() ) const override;
+
+	/*!
+	 * \brief Returns the token of a row for Qt::DisplayRole.
+	 * \param index The index of the row.
+	 * \param role The requested role.
+	 * \return The token, or an invalid QVariant for other roles.
+	 */
+	[[nodiscard]] QVariant data( const QModelIndex& index, int role ) const override;
+
+private:
+	const ZealdocProvider* m_provider; /*!< The provider the rows come from. */
+};
@@ -0,0 +1,108 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "zealmemorybudget.h"
+
+#include <QDebug>
+
+#include "zealdocprovider.h"
+
+ZealMemoryBudget::ZealMemoryBudget( qint64 bytes )
+	: m_budget{ bytes }
+{}
+
+qint64 ZealMemoryBudget::budget() const
+{
+	const QMutexLocker locker{ &m_mutex };
+	return m_budget;
+}
+
+void ZealMemoryBudget::setBudget( qint64 bytes )
+{
+	const QMutexLocker locker{ &m_mutex };
+	m_budget = bytes;
+	evict( nullptr );
+}
+
+qint64 ZealMemoryBudget::usage() const
+{
+	const QMutexLocker locker{ &m_mutex };
+	qint64		   total{ 0 };
+
+	for ( const auto* provider : m_providers ) { total += provider->memoryUsage(); }
+
+	return total;
+}
+
+void ZealMemoryBudget::add( ZealdocProvider* provider )
+{
+	const QMutexLocker locker{ &m_mutex };
+
+	if ( !m_providers.contains( provider ) ) { m_providers << provider; }
+
+	// The provider loaded its table before it was registered
+	evict( provider );
+}
+
+void ZealMemoryBudget::remove( ZealdocProvider* provider )
+{
+	const QMutexLocker locker{ &m_mutex };
+	m_providers.removeAll( provider );
+}
+
+void ZealMemoryBudget::loaded( ZealdocProvider* provider )
+{
+	const QMutexLocker locker{ &m_mutex };
+	evict( provider );
+}
+
+quint64 ZealMemoryBudget::stamp() { return ++m_clock; }
+
+void ZealMemoryBudget::evict( const ZealdocProvider* keep )
+{
+	if ( m_budget <= 0 ) { return; }
+
+	qint64 total{ 0 };
+
+	for ( const auto* provider : qAsConst( m_providers ) ) { total += provider->memoryUsage(); }
+
+	while ( total > m_budget )
+	{
+		ZealdocProvider* coldest{ nullptr };
+
+		for ( auto* provider : qAsConst( m_providers ) )
+		{
+			if ( provider == keep || !provider->isLoaded() ) { continue; }
+
+			if ( !coldest || provider->lastUsed() < coldest->lastUsed() ) { coldest = provider; }
+		}
+
+		// Only the provider in use is left, it stays even if it alone is over budget
+		if ( !coldest ) { return; }
+
+		const qint64 freed{ coldest->memoryUsage() };
+		coldest->unload();
+		total -= freed;
+
+		qDebug() << "Dropped the symbol table of" << coldest->name() << "to free" << freed << "bytes";
+	}
+}
@@ -0,0 +1,101 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QtGlobal>
+#include <atomic>
+
+class ZealdocProvider;
+
+/*!
+ * \class ZealMemoryBudget
+ * \brief Keeps the token tables of all providers within one memory budget.
+ *
+ * Providers register here and report each time they load their table. When the
+ * loaded tables together exceed the budget, the tables of the providers that were
+ * used least recently are dropped. Those providers rebuild them from their docset
+ * the next time they are asked for a token.
+ *
+ * Tables are reloaded on whichever thread asks for them, so declaration lookups can
+ * evict too. The budget takes its own lock and then each provider's, never the other
+ * way around; providers report a load only after releasing theirs.
+ */
+class ZealMemoryBudget
+{
+	Q_DISABLE_COPY_MOVE( ZealMemoryBudget )
+
+public:
+	/*!
+	 * \brief Constructs a budget of \a bytes, 0 for no limit.
+	 */
+	explicit ZealMemoryBudget( qint64 bytes = 0 );
+
+	/*!
+	 * \brief Returns the budget in bytes, 0 means no limit.
+	 */
+	[[nodiscard]] qint64 budget() const;
+
+	/*!
+	 * \brief Changes the budget and evicts tables if it shrank.
+	 */
+	void setBudget( qint64 bytes );
+
+	/*!
+	 * \brief Returns the memory used by all loaded tables.
+	 */
+	[[nodiscard]] qint64 usage() const;
+
+	/*!
+	 * \brief Starts accounting for \a provider, evicts others if its table does not fit.
+	 */
+	void add( ZealdocProvider* provider );
+
+	/*!
+	 * \brief Stops accounting for \a provider.
+	 */
+	void remove( ZealdocProvider* provider );
+
+	/*!
+	 * \brief Called by \a provider after it loaded its table, evicts others if needed.
+	 */
+	void loaded( ZealdocProvider* provider );
+
+	/*!
+	 * \brief Returns a new, increasing use stamp, for least-recently-used ordering.
+	 */
+	quint64 stamp();
+
+private:
+	/*!
+	 * \brief Drops tables, coldest first, until the budget holds. \a keep is never dropped.
+	 * Called with m_mutex held.
+	 */
+	void evict( const ZealdocProvider* keep );
+
+	mutable QMutex		m_mutex; /*!< Guards m_budget and m_providers, held while evicting. */
+	qint64			m_budget;
+	std::atomic<quint64>	m_clock{ 0 };
+	QList<ZealdocProvider*> m_providers;
+};
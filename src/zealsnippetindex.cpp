@@ -0,0 +1,256 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "zealsnippetindex.h"
+
+#include <registry/documentarchive.h>
+
+#include <QMutexLocker>
+#include <QTextDocumentFragment>
+#include <cstring>
+
+namespace {
+bool isSpace( char c ) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'; }
+
+/*!
+ * \brief Returns the first occurrence of \a needle in [\a from, \a end), or \a end.
+ */
+const char* find( const char* from, const char* end, const char* needle )
+{
+	const std::size_t length{ std::strlen( needle ) };
+
+	for ( const char* p = from; p + length <= end; ++p )
+	{
+		p = static_cast<const char*>( std::memchr( p, needle[0], end - p ) );
+
+		if ( !p || p + length > end ) { break; }
+
+		if ( std::memcmp( p, needle, length ) == 0 ) { return p; }
+	}
+
+	return end;
+}
+
+bool startsWithTag( const char* p, const char* end, const char* name )
+{
+	const std::size_t length{ std::strlen( name ) };
+
+	if ( p + 1 + length >= end || p[0] != '<' ) { return false; }
+
+	for ( std::size_t i = 0; i < length; ++i )
+	{
+		if ( ( p[1 + i] | 0x20 ) != name[i] ) { return false; }
+	}
+
+	const char next{ p[1 + length] };
+	return next == '>' || next == '/' || isSpace( next );
+}
+}    // namespace
+
+ZealSnippetIndex::ZealSnippetIndex( int maxPages )
+	: m_maxPages{ maxPages }
+{}
+
+ZealSnippetIndex::~ZealSnippetIndex() = default;
+
+QString ZealSnippetIndex::snippet( const QUrl& url )
+{
+	const bool archived{ url.scheme() == QLatin1String( Zeal::Registry::DocumentArchive::Scheme ) };
+
+	if ( !url.isLocalFile() && !archived ) { return {}; }
+
+	const QMutexLocker locker{ &m_mutex };
+	const Page*	   page{ this->page( url.adjusted( QUrl::RemoveFragment ) ) };
+
+	if ( !page ) { return {}; }
+
+	const QString fragment{ url.fragment( QUrl::FullyDecoded ) };
+
+	if ( fragment.isEmpty() ) { return paragraphAfter( *page, 0 ); }
+
+	const auto anchor{ page->anchors.constFind( fragment ) };
+
+	return anchor != page->anchors.constEnd() ? paragraphAfter( *page, *anchor ) : QString{};
+}
+
+ZealSnippetIndex::Page* ZealSnippetIndex::page( const QUrl& url )
+{
+	for ( auto it = m_pages.begin(); it != m_pages.end(); ++it )
+	{
+		if ( ( *it )->url == url )
+		{
+			m_pages.splice( m_pages.begin(), m_pages, it );
+			return m_pages.front().get();
+		}
+	}
+
+	auto page{ std::make_unique<Page>() };
+	page->url = url;
+
+	if ( url.isLocalFile() )
+	{
+		page->file.setFileName( url.toLocalFile() );
+
+		if ( !page->file.open( QIODevice::ReadOnly ) ) { return nullptr; }
+
+		page->size = page->file.size();
+		page->data = reinterpret_cast<const char*>( page->file.map( 0, page->size ) );
+	}
+	else
+	{
+		page->buffer = Zeal::Registry::DocumentArchive::read( url );
+		page->size   = page->buffer.size();
+		page->data   = page->buffer.isEmpty() ? nullptr : page->buffer.constData();
+	}
+
+	if ( !page->data ) { return nullptr; }
+
+	indexAnchors( *page );
+
+	m_pages.push_front( std::move( page ) );
+
+	// Unmapped when the file is closed with the page
+	while ( static_cast<int>( m_pages.size() ) > m_maxPages ) { m_pages.pop_back(); }
+
+	return m_pages.front().get();
+}
+
+void ZealSnippetIndex::indexAnchors( Page& page )
+{
+	const char* const begin{ page.data };
+	const char* const end{ page.data + page.size };
+
+	for ( const char* p = begin; p < end; )
+	{
+		p = static_cast<const char*>( std::memchr( p, '<', end - p ) );
+
+		if ( !p ) { break; }
+
+		// Comments may hold anything, skip them whole
+		if ( end - p >= 4 && std::memcmp( p, "<!--", 4 ) == 0 )
+		{
+			const char* close{ find( p + 4, end, "-->" ) };
+			p = close == end ? end : close + 3;
+			continue;
+		}
+
+		const char* tagEnd{ static_cast<const char*>( std::memchr( p, '>', end - p ) ) };
+
+		if ( !tagEnd ) { break; }
+
+		// Only opening tags carry attributes
+		if ( p + 1 < tagEnd && p[1] != '/' && p[1] != '!' && p[1] != '?' )
+		{
+			for ( const char* a = p + 1; a + 4 < tagEnd; ++a )
+			{
+				const bool id{ isSpace( a[-1] ) && ( a[0] | 0x20 ) == 'i' && ( a[1] | 0x20 ) == 'd' };
+				const bool name{ isSpace( a[-1] ) && tagEnd - a > 6 && ( a[0] | 0x20 ) == 'n'
+						 && ( a[1] | 0x20 ) == 'a' && ( a[2] | 0x20 ) == 'm' && ( a[3] | 0x20 ) == 'e' };
+
+				if ( !id && !name ) { continue; }
+
+				const char* value{ a + ( id ? 2 : 4 ) };
+
+				while ( value < tagEnd && isSpace( *value ) ) { ++value; }
+
+				if ( value >= tagEnd || *value != '=' ) { continue; }
+
+				++value;
+
+				while ( value < tagEnd && isSpace( *value ) ) { ++value; }
+
+				const char quote{ value < tagEnd && ( *value == '"' || *value == '\'' ) ? *value : '\0' };
+
+				if ( quote ) { ++value; }
+
+				const char* valueEnd{ value };
+
+				while ( valueEnd < tagEnd
+					&& ( quote ? *valueEnd != quote : !isSpace( *valueEnd ) ) )
+				{
+					++valueEnd;
+				}
+
+				QString anchor{ QString::fromUtf8( value, static_cast<int>( valueEnd - value ) ) };
+
+				if ( anchor.contains( QLatin1Char( '&' ) ) )
+				{
+					anchor = QTextDocumentFragment::fromHtml( anchor ).toPlainText();
+				}
+
+				// The first element with an anchor wins, like in a browser
+				if ( !anchor.isEmpty() && !page.anchors.contains( anchor ) )
+				{
+					page.anchors.insert( anchor, tagEnd + 1 - begin );
+				}
+
+				a = valueEnd;
+			}
+		}
+
+		p = tagEnd + 1;
+	}
+}
+
+QString ZealSnippetIndex::paragraphAfter( const Page& page, qint64 offset )
+{
+	// Don't wander off too far from the anchor looking for a paragraph
+	constexpr qint64 searchLimit{ 64 * 1024 };
+
+	const char* const end{ page.data + page.size };
+	const char*	  p{ page.data + offset };
+	const char* const limit{ page.size - offset > searchLimit ? p + searchLimit : end };
+
+	for ( ; p < limit; ++p )
+	{
+		p = static_cast<const char*>( std::memchr( p, '<', limit - p ) );
+
+		if ( !p ) { return {}; }
+
+		if ( startsWithTag( p, end, "p" ) ) { break; }
+	}
+
+	if ( p >= limit ) { return {}; }
+
+	const char* close{ p + 2 };
+
+	// Up to the closing tag or the next paragraph, whichever comes first
+	for ( ; close < end; ++close )
+	{
+		close = static_cast<const char*>( std::memchr( close, '<', end - close ) );
+
+		if ( !close ) { close = end; break; }
+
+		if ( startsWithTag( close, end, "/p" ) || startsWithTag( close, end, "p" ) ) { break; }
+	}
+
+	const QString html{ QString::fromUtf8( p, static_cast<int>( close - p ) ) };
+	QString	      text{ QTextDocumentFragment::fromHtml( html ).toPlainText().simplified() };
+
+	if ( text.size() > MaxSnippetLength )
+	{
+		text.truncate( MaxSnippetLength - 1 );
+		text += QChar( 0x2026 );    // Ellipsis
+	}
+
+	return text;
+}
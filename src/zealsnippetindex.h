@@ -0,0 +1,108 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+#include <list>
+#include <memory>
+
+/*!
+ * \class ZealSnippetIndex
+ * \brief Extracts short descriptions of documented symbols from docset pages.
+ *
+ * A snippet is the first paragraph that follows a symbol's anchor. Pages are mapped
+ * into memory with QFile::map() and scanned tag by tag once, recording the byte
+ * offset of every element carrying an `id` or `name` attribute. Later snippets from
+ * the same page are a hash lookup and a short scan from that offset, so even a
+ * multi-megabyte reference page is never parsed as a whole.
+ *
+ * Pages of archived docsets are inflated through Zeal::Registry::DocumentArchive
+ * instead of being mapped.
+ *
+ * A small number of pages stay mapped, least recently used first out. The index
+ * can be used from any thread.
+ */
+class ZealSnippetIndex
+{
+	Q_DISABLE_COPY_MOVE( ZealSnippetIndex )
+
+public:
+	/*!
+	 * \brief Constructs an index keeping up to \a maxPages pages mapped.
+	 */
+	explicit ZealSnippetIndex( int maxPages = 16 );
+
+	/*!
+	 * \brief Unmaps all pages.
+	 */
+	~ZealSnippetIndex();
+
+	/*!
+	 * \brief Returns the plain text snippet documented at \a url.
+	 * \param url A local file or archived page URL, its fragment names the anchor.
+	 * \return The snippet, empty if the page or the anchor can't be found.
+	 */
+	QString snippet( const QUrl& url );
+
+	/*!
+	 * \brief The longest snippet returned, in characters.
+	 */
+	static constexpr int MaxSnippetLength = 600;
+
+private:
+	/*!
+	 * \brief A mapped page and the offsets of its anchors.
+	 */
+	struct Page
+	{
+		QUrl			url;
+		QFile			file;
+		QByteArray		buffer;	   /*!< The page, if it is archived. */
+		const char*		data = nullptr;
+		qint64			size = 0;
+		QHash<QString, qint64> anchors;	   /*!< Anchor to the offset just past its tag. */
+	};
+
+	/*!
+	 * \brief Returns the page at \a url, mapping and indexing it if needed. Needs m_mutex.
+	 */
+	Page* page( const QUrl& url );
+
+	/*!
+	 * \brief Records the anchors of \a page with a single pass over its tags.
+	 */
+	static void indexAnchors( Page& page );
+
+	/*!
+	 * \brief Returns the text of the first paragraph at or after \a offset.
+	 */
+	static QString paragraphAfter( const Page& page, qint64 offset );
+
+	int				  m_maxPages;
+	QMutex				  m_mutex;
+	std::list<std::unique_ptr<Page>> m_pages;    /*!< Most recently used first. */
+};
@@ -0,0 +1,574 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "zealtokentable.h"
+
+#include <registry/documentarchive.h>
+#include <registry/searchscore.h>
+
+#include <QDir>
+#include <QSet>
+#include <algorithm>
+#include <utility>
+
+namespace {
+/*!
+ * \brief Returns an anchor as QUrl::fragment( QUrl::FullyDecoded ) would.
+ *
+ * Docset::pageUrl() sets `//apple_ref` anchors verbatim and all others in
+ * tolerant mode, where percent escapes are kept and decoded on the way out.
+ */
+bool needsDecoding( QStringView fragment, bool verbatim )
+{
+	return !verbatim && std::find( fragment.begin(), fragment.end(), QLatin1Char( '%' ) ) != fragment.end();
+}
+
+QString decodedFragment( QStringView fragment, bool verbatim )
+{
+	return needsDecoding( fragment, verbatim ) ? QUrl::fromPercentEncoding( fragment.toUtf8() ) : fragment.toString();
+}
+
+/*!
+ * \brief Hashes a page and anchor for the reverse index.
+ *
+ * Links followed inside a page may differ in encoding or in `..` segments from
+ * the URLs the docset produced, so both sides hash the decoded anchor and the
+ * cleaned page path, relative to the source's documents.
+ */
+uint locationHash( uint pageHash, QStringView fragment )
+{
+	return pageHash ^ ( qHash( fragment ) + 0x9e3779b9u + ( pageHash << 6 ) + ( pageHash >> 2 ) );
+}
+
+uint pageHash( const QString& cleanPath, int source ) { return qHash( QStringView( cleanPath ), uint( source ) ); }
+
+/*!
+ * \brief Folds a token the way SearchScore folds symbol names.
+ */
+QByteArray foldToken( QStringView token )
+{
+	const QByteArray utf8{ token.toUtf8() };
+	QByteArray	 folded( utf8.size(), Qt::Uninitialized );
+
+	// QByteArray always has room for the terminating NUL written here
+	Zeal::Registry::SearchScore::foldHaystack( reinterpret_cast<const unsigned char*>( utf8.constData() ),
+						   utf8.size(),
+						   reinterpret_cast<unsigned char*>( folded.data() ) );
+	return folded;
+}
+
+/*!
+ * \brief Calls \a f with the start of every component of \a folded, 0 included.
+ */
+template <typename F>
+void forEachSuffix( const QByteArray& folded, F f )
+{
+	for ( int i = 0; i < folded.size(); ++i )
+	{
+		if ( ( i == 0 || folded.at( i - 1 ) == '.' ) && folded.at( i ) != '.' ) { f( i ); }
+	}
+}
+
+uint suffixHash( const QByteArray& folded, int start )
+{
+	return qHash( QByteArray::fromRawData( folded.constData() + start, folded.size() - start ) );
+}
+}    // namespace
+
+ZealTokenTable::Builder::Builder( const QString& documentPath ) { addSource( documentPath ); }
+
+int ZealTokenTable::Builder::addSource( const QString& documentPath, int priority )
+{
+	m_documentPaths << documentPath;
+	m_priorities << priority;
+
+	return m_documentPaths.size() - 1;
+}
+
+void ZealTokenTable::Builder::add( const QString&				 group,
+				   const QString&				 token,
+				   const Zeal::Registry::Docset::PageLocation& location )
+{
+	int groupIndex{ m_groupNames.lastIndexOf( group ) };
+
+	if ( groupIndex < 0 )
+	{
+		groupIndex = m_groupNames.size();
+		m_groupNames << group;
+	}
+
+	Q_ASSERT( !m_documentPaths.isEmpty() );
+
+	const int source{ m_documentPaths.size() - 1 };
+	auto	  pageId{ m_pageIds.constFind( qMakePair( source, location.path ) ) };
+
+	if ( pageId == m_pageIds.constEnd() )
+	{
+		pageId = m_pageIds.insert( qMakePair( source, location.path ),
+					   static_cast<quint32>( m_pagePaths.size() ) );
+		m_pagePaths << location.path;
+		m_pageSources << static_cast<quint16>( source );
+	}
+
+	const quint32 page{ *pageId | ( location.decodedFragment ? PageDecodedFragment : 0u ) };
+
+	m_entries.push_back( { token, groupIndex, page, location.fragment, m_priorities.last() } );
+}
+
+ZealTokenTable ZealTokenTable::Builder::build()
+{
+	ZealTokenTable table;
+
+	// Among equal tokens, higher priorities first and then the entry added last
+	std::reverse( m_entries.begin(), m_entries.end() );
+	std::stable_sort( m_entries.begin(), m_entries.end(), []( const Entry& a, const Entry& b ) {
+		return a.token < b.token || ( a.token == b.token && a.priority > b.priority );
+	} );
+
+	qsizetype arenaSize{ 0 };
+
+	for ( std::size_t i = 0; i < m_entries.size(); ++i )
+	{
+		if ( i == 0 || m_entries[i].token != m_entries[i - 1].token )
+		{
+			arenaSize += m_entries[i].token.size();
+		}
+	}
+
+	table.m_arena.reserve( arenaSize );
+	table.m_documentPaths = m_documentPaths;
+	table.m_pagePaths     = m_pagePaths;
+	table.m_pageSources   = m_pageSources;
+	table.m_groupNames    = m_groupNames;
+
+	// Fragments of the entries, copied into their own arena below
+	QStringList fragments;
+
+	// (group, token index) pairs, sorted below into the per-group ranges
+	std::vector<std::pair<int, quint32>> memberships;
+	memberships.reserve( m_entries.size() );
+
+	// (page, anchor) of the current token's entries. Most tokens have a single entry,
+	// so the set is only filled once a second one shows up.
+	QSet<QPair<quint32, QString>> tokenEntries;
+
+	for ( std::size_t i = 0; i < m_entries.size(); ++i )
+	{
+		Entry& entry{ m_entries[i] };
+
+		if ( i == 0 || entry.token != m_entries[i - 1].token )
+		{
+			table.m_offsets << static_cast<quint32>( table.m_arena.size() );
+			table.m_arena += entry.token;
+			table.m_entryOffsets << static_cast<quint32>( table.m_pages.size() );
+			tokenEntries.clear();
+		}
+
+		// Same page and anchor under another group is the same entry
+		const int first{ static_cast<int>( table.m_entryOffsets.last() ) };
+		bool	  duplicate{ false };
+
+		if ( table.m_pages.size() > first )
+		{
+			if ( tokenEntries.isEmpty() ) { tokenEntries.insert( qMakePair( table.m_pages.at( first ), fragments.at( first ) ) ); }
+
+			duplicate = tokenEntries.contains( qMakePair( entry.page, entry.fragment ) );
+		}
+
+		if ( !duplicate )
+		{
+			if ( !tokenEntries.isEmpty() ) { tokenEntries.insert( qMakePair( entry.page, entry.fragment ) ); }
+
+			table.m_pages << entry.page;
+			table.m_entryGroups << static_cast<quint16>( entry.group );
+			fragments << entry.fragment;
+		}
+
+		memberships.emplace_back( entry.group,
+					  static_cast<quint32>( table.m_offsets.size() - 1 ) );
+
+		// Release the copies as we go, the arenas hold the characters now
+		entry.token.clear();
+		entry.fragment.clear();
+	}
+
+	table.m_offsets << static_cast<quint32>( table.m_arena.size() );
+	table.m_entryOffsets << static_cast<quint32>( table.m_pages.size() );
+
+	qsizetype fragmentsSize{ 0 };
+
+	for ( const QString& fragment : qAsConst( fragments ) ) { fragmentsSize += fragment.size(); }
+
+	table.m_fragmentArena.reserve( fragmentsSize );
+	table.m_fragmentOffsets.reserve( fragments.size() + 1 );
+
+	for ( const QString& fragment : qAsConst( fragments ) )
+	{
+		table.m_fragmentOffsets << static_cast<quint32>( table.m_fragmentArena.size() );
+		table.m_fragmentArena += fragment;
+	}
+
+	table.m_fragmentOffsets << static_cast<quint32>( table.m_fragmentArena.size() );
+	fragments.clear();
+
+	// Reverse index, filled backwards so that values() lists lower indices first
+	QVector<uint> pageHashes;
+	pageHashes.reserve( table.m_pagePaths.size() );
+
+	for ( int p = 0; p < table.m_pagePaths.size(); ++p )
+	{
+		pageHashes << pageHash( QDir::cleanPath( table.m_pagePaths.at( p ) ), table.m_pageSources.at( p ) );
+	}
+
+	table.m_urlIndex.reserve( table.entryCount() );
+
+	for ( int e = table.entryCount() - 1; e >= 0; --e )
+	{
+		const quint32	  page{ table.m_pages.at( e ) };
+		const uint	  pageHashValue{ pageHashes.at( static_cast<int>( page & ~PageDecodedFragment ) ) };
+		const QStringView fragment{ table.entryFragment( e ) };
+
+		// Most anchors have nothing to decode and are hashed in place
+		const uint hash{ needsDecoding( fragment, ( page & PageDecodedFragment ) != 0 )
+					 ? locationHash( pageHashValue, decodedFragment( fragment, false ) )
+					 : locationHash( pageHashValue, fragment ) };
+
+		table.m_urlIndex.insert( hash, static_cast<quint32>( e ) );
+	}
+
+	for ( int i = 0; i < table.size(); ++i )
+	{
+		const QByteArray folded{ foldToken( table.token( i ) ) };
+
+		forEachSuffix( folded, [&]( int start ) {
+			table.m_suffixIndex.append( { suffixHash( folded, start ), static_cast<quint32>( i ) } );
+		} );
+	}
+
+	std::sort( table.m_suffixIndex.begin(), table.m_suffixIndex.end() );
+	table.m_suffixIndex.squeeze();
+
+	std::sort( memberships.begin(), memberships.end() );
+	memberships.erase( std::unique( memberships.begin(), memberships.end() ), memberships.end() );
+
+	table.m_groupTokens.reserve( static_cast<int>( memberships.size() ) );
+
+	for ( int group = 0, i = 0; group < m_groupNames.size(); ++group )
+	{
+		table.m_groupOffsets << static_cast<quint32>( table.m_groupTokens.size() );
+
+		for ( ; i < static_cast<int>( memberships.size() ) && memberships[i].first == group; ++i )
+		{
+			table.m_groupTokens << memberships[i].second;
+		}
+	}
+
+	table.m_groupOffsets << static_cast<quint32>( table.m_groupTokens.size() );
+
+	// Every path is a separately allocated string with a small header
+	constexpr qint64 stringOverhead{ 24 };
+	qint64		 pathBytes{ 0 };
+
+	for ( const QString& path : qAsConst( table.m_pagePaths ) )
+	{
+		pathBytes += stringOverhead + path.capacity() * qint64( sizeof( QChar ) );
+	}
+
+	table.m_memoryUsage = table.m_arena.capacity() * qint64( sizeof( QChar ) )
+			      + table.m_offsets.capacity() * qint64( sizeof( quint32 ) )
+			      + table.m_pagePaths.size() * qint64( sizeof( void* ) + sizeof( quint16 ) ) + pathBytes
+			      + table.m_pages.capacity() * qint64( sizeof( quint32 ) )
+			      + table.m_entryOffsets.capacity() * qint64( sizeof( quint32 ) )
+			      + table.m_entryGroups.capacity() * qint64( sizeof( quint16 ) )
+			      + table.m_fragmentArena.capacity() * qint64( sizeof( QChar ) )
+			      + table.m_fragmentOffsets.capacity() * qint64( sizeof( quint32 ) )
+			      + table.m_urlIndex.size() * qint64( sizeof( uint ) + sizeof( quint32 ) + 2 * sizeof( void* ) )
+			      + table.m_suffixIndex.capacity() * qint64( sizeof( QPair<uint, quint32> ) )
+			      + ( table.m_groupTokens.capacity() + table.m_groupOffsets.capacity() )
+					* qint64( sizeof( quint32 ) );
+
+	m_entries.clear();
+	m_entries.shrink_to_fit();
+	m_groupNames.clear();
+	m_pagePaths.clear();
+	m_pageSources.clear();
+	m_pageIds.clear();
+	m_documentPaths.clear();
+	m_priorities.clear();
+
+	return table;
+}
+
+int ZealTokenTable::size() const { return qMax( 0, m_offsets.size() - 1 ); }
+
+QStringView ZealTokenTable::token( int index ) const
+{
+	return QStringView{ m_arena }.mid( m_offsets.at( index ),
+					   m_offsets.at( index + 1 ) - m_offsets.at( index ) );
+}
+
+QString ZealTokenTable::tokenString( int index ) const { return token( index ).toString(); }
+
+QUrl ZealTokenTable::url( int index ) const { return entryUrl( firstEntry( index ) ); }
+
+int ZealTokenTable::source( int index ) const { return entrySource( firstEntry( index ) ); }
+
+int ZealTokenTable::sourceCount() const { return m_documentPaths.size(); }
+
+int ZealTokenTable::entryCount() const { return m_pages.size(); }
+
+int ZealTokenTable::entryCount( int index ) const
+{
+	return static_cast<int>( m_entryOffsets.at( index + 1 ) - m_entryOffsets.at( index ) );
+}
+
+int ZealTokenTable::firstEntry( int index ) const { return static_cast<int>( m_entryOffsets.at( index ) ); }
+
+int ZealTokenTable::entryToken( int entry ) const
+{
+	// The run whose start is the last one not after the entry
+	const auto it{ std::upper_bound( m_entryOffsets.cbegin(), m_entryOffsets.cend(), static_cast<quint32>( entry ) ) };
+	return static_cast<int>( it - m_entryOffsets.cbegin() ) - 1;
+}
+
+int ZealTokenTable::entryGroup( int entry ) const { return m_entryGroups.at( entry ); }
+
+int ZealTokenTable::entrySource( int entry ) const
+{
+	return m_pageSources.at( static_cast<int>( m_pages.at( entry ) & ~PageDecodedFragment ) );
+}
+
+QStringView ZealTokenTable::entryFragment( int entry ) const
+{
+	return QStringView{ m_fragmentArena }.mid( m_fragmentOffsets.at( entry ),
+						   m_fragmentOffsets.at( entry + 1 ) - m_fragmentOffsets.at( entry ) );
+}
+
+QUrl ZealTokenTable::entryUrl( int entry ) const
+{
+	const quint32 page{ m_pages.at( entry ) };
+	const int     pageId{ static_cast<int>( page & ~PageDecodedFragment ) };
+
+	Zeal::Registry::Docset::PageLocation location;
+	location.path		 = m_pagePaths.at( pageId );
+	location.fragment	 = entryFragment( entry ).toString();
+	location.decodedFragment = ( page & PageDecodedFragment ) != 0;
+
+	return Zeal::Registry::Docset::pageUrl( m_documentPaths.at( m_pageSources.at( pageId ) ), location );
+}
+
+int ZealTokenTable::bestEntry( int index, const QStringList& groups, const QStringList& words ) const
+{
+	const int first{ firstEntry( index ) };
+	const int last{ first + entryCount( index ) };
+
+	int best{ first };
+	int bestScore{ 0 };
+
+	for ( int entry = first; entry < last && last - first > 1; ++entry )
+	{
+		int score{ 0 };
+
+		// The group outweighs any number of matching words
+		const int groupRank{ groups.indexOf( m_groupNames.at( entryGroup( entry ) ) ) };
+
+		if ( groupRank >= 0 ) { score += 1000 * ( groups.size() - groupRank ); }
+
+		const QString fragment{ entryFragment( entry ).toString() };
+
+		for ( const QString& word : words )
+		{
+			if ( fragment.contains( word, Qt::CaseInsensitive ) ) { ++score; }
+		}
+
+		if ( score > bestScore )
+		{
+			bestScore = score;
+			best	  = entry;
+		}
+	}
+
+	return best;
+}
+
+int ZealTokenTable::indexOf( QStringView token ) const
+{
+	int first{ 0 };
+	int count{ size() };
+
+	// Plain lower_bound over the indices, comparing views into the arena
+	while ( count > 0 )
+	{
+		const int step{ count / 2 };
+		const int middle{ first + step };
+
+		if ( this->token( middle ) < token )
+		{
+			first = middle + 1;
+			count -= step + 1;
+		}
+		else { count = step; }
+	}
+
+	return first < size() && this->token( first ) == token ? first : -1;
+}
+
+int ZealTokenTable::indexOfClosest( QStringView token ) const
+{
+	const int exact{ indexOf( token ) };
+
+	if ( exact >= 0 || token.isEmpty() ) { return exact; }
+
+	const QByteArray query{ foldToken( token ) };
+	int		 best{ -1 };
+
+	// Longest suffix of the query first, the first one that matches anything decides
+	forEachSuffix( query, [&]( int start ) {
+		if ( best >= 0 ) { return; }
+
+		const QByteArray suffix{ QByteArray::fromRawData( query.constData() + start, query.size() - start ) };
+		const uint	 hash{ suffixHash( query, start ) };
+		const auto	 range{ std::equal_range( m_suffixIndex.cbegin(),
+						  m_suffixIndex.cend(),
+						  qMakePair( hash, quint32{ 0 } ),
+						  []( const QPair<uint, quint32>& a, const QPair<uint, quint32>& b ) {
+							  return a.first < b.first;
+						  } ) };
+
+		int bestScore{ 0 };
+
+		for ( auto it = range.first; it != range.second; ++it )
+		{
+			const QByteArray candidate{ foldToken( this->token( static_cast<int>( it->second ) ) ) };
+			const int	 matchIndex{ candidate.size() - suffix.size() };
+
+			// Hashes may collide, so confirm the suffix and that it starts a component
+			if ( matchIndex < 0 || !candidate.endsWith( suffix )
+			     || ( matchIndex > 0 && candidate.at( matchIndex - 1 ) != '.' ) )
+			{
+				continue;
+			}
+
+			const int score{ Zeal::Registry::SearchScore::scoreExact(
+				matchIndex,
+				suffix.size(),
+				reinterpret_cast<const unsigned char*>( candidate.constData() ),
+				candidate.size() ) };
+
+			if ( score > bestScore )
+			{
+				bestScore = score;
+				best	  = static_cast<int>( it->second );
+			}
+		}
+	} );
+
+	return best;
+}
+
+int ZealTokenTable::indexOfUrl( const QUrl& url ) const
+{
+	const int entry{ entryOfUrl( url ) };
+
+	return entry >= 0 ? entryToken( entry ) : -1;
+}
+
+int ZealTokenTable::entryOfUrl( const QUrl& url ) const
+{
+	const QString path{ QDir::cleanPath( url.path( QUrl::FullyDecoded ) ) };
+	const QString fragment{ url.fragment( QUrl::FullyDecoded ) };
+
+	for ( int source = 0; source < m_documentPaths.size(); ++source )
+	{
+		const QString relative{ relativePath( source, url, path ) };
+
+		if ( relative.isNull() ) { continue; }
+
+		const uint hash{ locationHash( pageHash( relative, source ), fragment ) };
+
+		// Candidates come most recently inserted first, i.e. in ascending index order
+		for ( auto it = m_urlIndex.constFind( hash ); it != m_urlIndex.cend() && it.key() == hash; ++it )
+		{
+			const int     entry{ static_cast<int>( it.value() ) };
+			const quint32 page{ m_pages.at( entry ) };
+			const int     pageId{ static_cast<int>( page & ~PageDecodedFragment ) };
+
+			if ( m_pageSources.at( pageId ) == source && QDir::cleanPath( m_pagePaths.at( pageId ) ) == relative
+			     && decodedFragment( entryFragment( entry ), ( page & PageDecodedFragment ) != 0 ) == fragment )
+			{
+				return entry;
+			}
+		}
+	}
+
+	return -1;
+}
+
+QString ZealTokenTable::relativePath( int source, const QUrl& url, const QString& cleanPath ) const
+{
+	const QString& documentPath{ m_documentPaths.at( source ) };
+
+	// Archived pages are the path below the archive's URL
+	if ( Zeal::Registry::DocumentArchive::isArchivePath( documentPath ) )
+	{
+		const QUrl archive{ documentPath };
+
+		return url.scheme() == archive.scheme() && url.host() == archive.host() ? cleanPath.mid( 1 ) : QString{};
+	}
+
+	if ( !url.isLocalFile() ) { return {}; }
+
+	const QString base{ QDir::cleanPath( QDir( documentPath ).absolutePath() ) + QLatin1Char( '/' ) };
+
+	return cleanPath.startsWith( base ) ? cleanPath.mid( base.size() ) : QString{};
+}
+
+qint64 ZealTokenTable::memoryUsage() const { return m_memoryUsage; }
+
+const QStringList& ZealTokenTable::groupNames() const { return m_groupNames; }
+
+int ZealTokenTable::groupSize( int group ) const
+{
+	if ( group < 0 || group >= m_groupNames.size() ) { return 0; }
+
+	return static_cast<int>( m_groupOffsets.at( group + 1 ) - m_groupOffsets.at( group ) );
+}
+
+int ZealTokenTable::groupToken( int group, int row ) const
+{
+	return static_cast<int>( m_groupTokens.at( m_groupOffsets.at( group ) + row ) );
+}
+
+int ZealTokenTable::groupEntry( int group, int row ) const
+{
+	const int index{ groupToken( group, row ) };
+	const int first{ firstEntry( index ) };
+	const int end{ first + entryCount( index ) };
+
+	// A token's entries are few, scanning them beats keeping a per-group entry list
+	for ( int entry = first; entry < end; ++entry )
+	{
+		if ( entryGroup( entry ) == group ) { return entry; }
+	}
+
+	return first;
+}
@@ -0,0 +1,320 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#pragma once
+
+#include <registry/docset.h>
+
+#include <QHash>
+#include <QMultiHash>
+#include <QPair>
+#include <QStringList>
+#include <QStringView>
+#include <QUrl>
+#include <QVector>
+#include <vector>
+
+/*!
+ * \class ZealTokenTable
+ * \brief Sorted, contiguous storage for the tokens of one docset.
+ *
+ * All token characters live in a single string arena and are addressed through an
+ * offset array, so a token costs a few bytes of bookkeeping instead of a separately
+ * allocated QString per copy. Tokens are unique and sorted, which makes lookups a
+ * binary search over contiguous memory.
+ *
+ * Groups (the docset's symbol types) don't copy tokens either: each group is a range
+ * of token indices in one shared array.
+ *
+ * URLs are not stored either. Every page path is kept once in a dictionary, and a
+ * token only holds the page's id and its anchor, from which url() builds the QUrl.
+ *
+ * A token can be documented in several places: overloads, same-named members of
+ * different classes, or the same name in several docsets. Each place is an entry,
+ * and the entries of a token are a contiguous run of (page, anchor, group) records.
+ * The first entry of a run is the default, see url().
+ *
+ * A table can merge several docsets. Each docset is a source with its own document
+ * path and priority. Runs list the entries of higher-priority sources first.
+ *
+ * Tables are built once with Builder and are immutable afterwards.
+ */
+class ZealTokenTable
+{
+public:
+	/*!
+	 * \class Builder
+	 * \brief Collects tokens and turns them into a ZealTokenTable.
+	 */
+	class Builder
+	{
+	public:
+		/*!
+		 * \brief Starts a table for a docset.
+		 * \param documentPath The docset's document path, pages are relative to it.
+		 */
+		explicit Builder( const QString& documentPath );
+
+		/*!
+		 * \brief Starts a table without a source, addSource() must be called before add().
+		 */
+		Builder() = default;
+
+		/*!
+		 * \brief Makes the following add() calls belong to another docset.
+		 * \param documentPath The docset's document path, pages are relative to it.
+		 * \param priority Among sources with the same token, the highest priority wins.
+		 * \return The id of the new source.
+		 */
+		int addSource( const QString& documentPath, int priority = 0 );
+
+		/*!
+		 * \brief Adds \a token to \a group.
+		 *
+		 * A token may be added to several groups and locations, every distinct
+		 * location becomes an entry of the token. Entries are ordered by source
+		 * priority, and within a priority the one added last comes first.
+		 *
+		 * \param group The name of the group, created on first use.
+		 * \param token The token.
+		 * \param location Where the token is documented.
+		 */
+		void add( const QString& group, const QString& token, const Zeal::Registry::Docset::PageLocation& location );
+
+		/*!
+		 * \brief Builds the table and leaves the builder empty.
+		 * \return The finished table.
+		 */
+		ZealTokenTable build();
+
+	private:
+		struct Entry
+		{
+			QString token;
+			int	group;
+			quint32 page;	   /*!< Path id, with PageDecodedFragment set as needed. */
+			QString fragment;
+			int	priority;  /*!< Priority of the entry's source. */
+		};
+
+		QStringList			      m_documentPaths;
+		QVector<int>			      m_priorities;
+		QStringList			      m_groupNames;
+		QStringList			      m_pagePaths;
+		QVector<quint16>		      m_pageSources;
+		QHash<QPair<int, QString>, quint32> m_pageIds;
+		std::vector<Entry>	m_entries;
+	};
+
+	/*!
+	 * \brief Returns the number of unique tokens.
+	 */
+	[[nodiscard]] int size() const;
+
+	/*!
+	 * \brief Returns the token at \a index, as a view into the arena.
+	 */
+	[[nodiscard]] QStringView token( int index ) const;
+
+	/*!
+	 * \brief Returns the token at \a index as a QString.
+	 */
+	[[nodiscard]] QString tokenString( int index ) const;
+
+	/*!
+	 * \brief Returns the URL of the default entry of the token at \a index, built on demand.
+	 */
+	[[nodiscard]] QUrl url( int index ) const;
+
+	/*!
+	 * \brief Returns the source (docset) of the default entry of the token at \a index.
+	 */
+	[[nodiscard]] int source( int index ) const;
+
+	/*!
+	 * \brief Returns the number of entries of all tokens.
+	 */
+	[[nodiscard]] int entryCount() const;
+
+	/*!
+	 * \brief Returns the number of entries of the token at \a index.
+	 */
+	[[nodiscard]] int entryCount( int index ) const;
+
+	/*!
+	 * \brief Returns the first (default) entry of the token at \a index.
+	 */
+	[[nodiscard]] int firstEntry( int index ) const;
+
+	/*!
+	 * \brief Returns the token an entry belongs to.
+	 */
+	[[nodiscard]] int entryToken( int entry ) const;
+
+	/*!
+	 * \brief Returns the group of an entry, an index into groupNames().
+	 */
+	[[nodiscard]] int entryGroup( int entry ) const;
+
+	/*!
+	 * \brief Returns the source (docset) of an entry.
+	 */
+	[[nodiscard]] int entrySource( int entry ) const;
+
+	/*!
+	 * \brief Returns the anchor of an entry, as a view into the fragment arena.
+	 */
+	[[nodiscard]] QStringView entryFragment( int entry ) const;
+
+	/*!
+	 * \brief Returns the URL of an entry, built on demand.
+	 */
+	[[nodiscard]] QUrl entryUrl( int entry ) const;
+
+	/*!
+	 * \brief Picks the entry of a token that fits a declaration best.
+	 *
+	 * An entry in one of \a groups wins, earlier groups first. Ties are broken by
+	 * how many of \a words occur in the entry's anchor, and then by run order.
+	 *
+	 * \param index The token.
+	 * \param groups Group names that fit the declaration's kind, best first.
+	 * \param words Words from the declaration's signature, e.g. parameter types.
+	 * \return The entry.
+	 */
+	[[nodiscard]] int bestEntry( int index, const QStringList& groups, const QStringList& words ) const;
+
+	/*!
+	 * \brief Returns the number of sources merged into the table.
+	 */
+	[[nodiscard]] int sourceCount() const;
+
+	/*!
+	 * \brief Finds a token by binary search.
+	 * \param token The token to look for.
+	 * \return The index of the token, or -1 if there is none.
+	 */
+	[[nodiscard]] int indexOf( QStringView token ) const;
+
+	/*!
+	 * \brief Finds the token that best matches an identifier that is not spelled like the docset's.
+	 *
+	 * Tries indexOf() first. Otherwise the identifier is folded like search queries
+	 * (case and `::`, `/`, `_` separators don't matter) and its leading scopes are
+	 * stripped one at a time, so `std::__1::vector` or `QML.Item` still find `std::vector`
+	 * or `Item`. Each step is a probe into an index of all component-aligned token
+	 * suffixes. Among the tokens found by the longest matching suffix, the one ranked
+	 * best by SearchScore::scoreExact() wins.
+	 *
+	 * \param token The identifier to look for.
+	 * \return The index of the token, or -1 if there is none.
+	 */
+	[[nodiscard]] int indexOfClosest( QStringView token ) const;
+
+	/*!
+	 * \brief Finds the token documented at \a url.
+	 *
+	 * URLs are compared by their decoded path and fragment, through a hash built
+	 * with the table, so this does not scan the tokens.
+	 *
+	 * \param url The URL to look for.
+	 * \return The index of the first token with that URL, or -1 if there is none.
+	 */
+	[[nodiscard]] int indexOfUrl( const QUrl& url ) const;
+
+	/*!
+	 * \brief Like indexOfUrl(), but returns the entry documented at \a url.
+	 */
+	[[nodiscard]] int entryOfUrl( const QUrl& url ) const;
+
+	/*!
+	 * \brief Returns the approximate number of bytes the table occupies.
+	 *
+	 * Counts the token and anchor arenas, the page path dictionary including its
+	 * strings, the per-entry arrays, the reverse and suffix indices and the groups.
+	 * Computed once when the table is built.
+	 */
+	[[nodiscard]] qint64 memoryUsage() const;
+
+	/*!
+	 * \brief Returns the names of all groups that have tokens, in docset order.
+	 */
+	[[nodiscard]] const QStringList& groupNames() const;
+
+	/*!
+	 * \brief Returns the number of tokens in the group at \a group.
+	 */
+	[[nodiscard]] int groupSize( int group ) const;
+
+	/*!
+	 * \brief Returns the token index of the \a row-th token in \a group.
+	 */
+	[[nodiscard]] int groupToken( int group, int row ) const;
+
+	/*!
+	 * \brief Returns the entry behind the \a row-th token in \a group, the first one
+	 * the token has in that group.
+	 */
+	[[nodiscard]] int groupEntry( int group, int row ) const;
+
+private:
+	/*!
+	 * \brief Set in a page entry when the fragment is an `//apple_ref` or `//dash_ref` anchor.
+	 */
+	static constexpr quint32 PageDecodedFragment = 0x80000000u;
+
+	/*!
+	 * \brief Returns \a cleanPath, the cleaned path of \a url, relative to the documents of \a source.
+	 * \return A null string if \a url doesn't point into that source.
+	 */
+	[[nodiscard]] QString relativePath( int source, const QUrl& url, const QString& cleanPath ) const;
+
+	QString		 m_arena;	 /*!< The characters of all tokens, back to back. */
+	QVector<quint32> m_offsets;	 /*!< Start of each token in m_arena, plus the end. */
+
+	QStringList	 m_documentPaths;     /*!< Base of the page paths, per source. */
+	QStringList	 m_pagePaths;	      /*!< Each page path once, indexed by path id. */
+	QVector<quint16> m_pageSources;	      /*!< Source per path id. */
+	QVector<quint32> m_entryOffsets;      /*!< First entry of each token, plus the end. */
+	QVector<quint32> m_pages;	      /*!< Path id per entry, plus PageDecodedFragment. */
+	QVector<quint16> m_entryGroups;	      /*!< Group per entry. */
+	QString		 m_fragmentArena;     /*!< The anchors of all entries, back to back. */
+	QVector<quint32> m_fragmentOffsets;   /*!< Start of each anchor, plus the end. */
+
+	/*!
+	 * Hash of the cleaned page path and decoded anchor to entry index. Only the hash
+	 * is stored, lookups confirm candidates against the page dictionary and anchors.
+	 */
+	QMultiHash<uint, quint32> m_urlIndex;
+
+	/*!
+	 * (hash, token index) for every suffix of every folded token that starts a
+	 * component, the whole token included, sorted by hash.
+	 */
+	QVector<QPair<uint, quint32>> m_suffixIndex;
+
+	QStringList	 m_groupNames;
+	QVector<quint32> m_groupTokens;	   /*!< Token indices of all groups, group by group. */
+	QVector<quint32> m_groupOffsets;   /*!< Start of each group in m_groupTokens, plus the end. */
+
+	qint64 m_memoryUsage = 0;	   /*!< Computed by Builder::build(). */
+};
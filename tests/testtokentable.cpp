@@ -0,0 +1,125 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include <registry/searchscore.h>
+#include <zealtokentable.h>
+
+#include <QtTest>
+
+using Zeal::Registry::Docset;
+
+/*!
+ * \brief Tests the lookups of ZealTokenTable.
+ */
+class TestTokenTable : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void closest_data();
+	void closest();
+	void groupEntry();
+	void scoreExactAfterDot();
+};
+
+namespace {
+ZealTokenTable table( const QStringList& tokens )
+{
+	ZealTokenTable::Builder builder{ QStringLiteral( "/docs" ) };
+
+	for ( const QString& token : tokens )
+	{
+		builder.add( QStringLiteral( "Class" ), token, Docset::PageLocation{ QStringLiteral( "index.html" ), token } );
+	}
+
+	return builder.build();
+}
+
+int scoreExact( const char* value, int matchIndex, int matchLen )
+{
+	return Zeal::Registry::SearchScore::scoreExact(
+		matchIndex, matchLen, reinterpret_cast<const unsigned char*>( value ), int( qstrlen( value ) ) );
+}
+}    // namespace
+
+void TestTokenTable::closest_data()
+{
+	QTest::addColumn<QStringList>( "tokens" );
+	QTest::addColumn<QString>( "query" );
+	QTest::addColumn<QString>( "expected" );
+
+	const QStringList vectors{ QStringLiteral( "boost::container::vector" ), QStringLiteral( "std::vector" ) };
+
+	QTest::newRow( "exact" ) << vectors << QStringLiteral( "std::vector" ) << QStringLiteral( "std::vector" );
+	QTest::newRow( "inline namespace" ) << vectors << QStringLiteral( "std::__1::vector" )
+					    << QStringLiteral( "std::vector" );
+	QTest::newRow( "last component" ) << vectors << QStringLiteral( "vector" ) << QStringLiteral( "std::vector" );
+	QTest::newRow( "QML prefix" ) << QStringList{ QStringLiteral( "Item" ), QStringLiteral( "QtQuick.Controls.Item" ) }
+				      << QStringLiteral( "QML.Item" ) << QStringLiteral( "Item" );
+	QTest::newRow( "no match" ) << vectors << QStringLiteral( "std::list" ) << QString{};
+}
+
+void TestTokenTable::closest()
+{
+	QFETCH( QStringList, tokens );
+	QFETCH( QString, query );
+	QFETCH( QString, expected );
+
+	const ZealTokenTable tokenTable{ table( tokens ) };
+	const int	     index{ tokenTable.indexOfClosest( query ) };
+
+	QCOMPARE( index >= 0 ? tokenTable.tokenString( index ) : QString{}, expected );
+}
+
+void TestTokenTable::groupEntry()
+{
+	ZealTokenTable::Builder builder{ QStringLiteral( "/docs" ) };
+	builder.add( QStringLiteral( "Function" ),
+		     QStringLiteral( "size" ),
+		     Docset::PageLocation{ QStringLiteral( "functions.html" ), QStringLiteral( "size" ) } );
+	builder.add( QStringLiteral( "Method" ),
+		     QStringLiteral( "size" ),
+		     Docset::PageLocation{ QStringLiteral( "methods.html" ), QStringLiteral( "size" ) } );
+
+	const ZealTokenTable tokenTable{ builder.build() };
+
+	// The same token listed in two groups opens each group's own page
+	const int functions{ tokenTable.groupNames().indexOf( QStringLiteral( "Function" ) ) };
+	const int methods{ tokenTable.groupNames().indexOf( QStringLiteral( "Method" ) ) };
+
+	QCOMPARE( tokenTable.entryUrl( tokenTable.groupEntry( functions, 0 ) ).path(), QStringLiteral( "/docs/functions.html" ) );
+	QCOMPARE( tokenTable.entryUrl( tokenTable.groupEntry( methods, 0 ) ).path(), QStringLiteral( "/docs/methods.html" ) );
+}
+
+void TestTokenTable::scoreExactAfterDot()
+{
+	// A match after a dot scores as if it started the name, minus one
+	QCOMPARE( scoreExact( "vector", 0, 6 ), 100 );
+	QCOMPARE( scoreExact( "std:.vector", 5, 6 ), 99 );
+
+	// Every further dot before the match costs a point
+	QCOMPARE( scoreExact( "boost:.container:.vector", 18, 6 ), 98 );
+}
+
+QTEST_GUILESS_MAIN( TestTokenTable )
+
+#include "testtokentable.moc"
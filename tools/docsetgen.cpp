@@ -0,0 +1,138 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "docsetgenerator.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+namespace {
+/*!
+ * \brief Parses a count with an optional `k` or `M` suffix, like 250k or 20M.
+ */
+qint64 parseCount( QString text, bool* ok )
+{
+	qint64 factor{ 1 };
+
+	if ( text.endsWith( QLatin1Char( 'k' ), Qt::CaseInsensitive ) ) { factor = 1000; }
+	else if ( text.endsWith( QLatin1Char( 'M' ) ) ) { factor = 1000000; }
+
+	if ( factor > 1 ) { text.chop( 1 ); }
+
+	return text.toLongLong( ok ) * factor;
+}
+}    // namespace
+
+int main( int argc, char* argv[] )
+{
+	QCoreApplication app{ argc, argv };
+	QCoreApplication::setApplicationName( QStringLiteral( "kdevzealdoc-docsetgen" ) );
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription( QStringLiteral( "Writes a synthetic Dash or ZDash docset." ) );
+	parser.addHelpOption();
+	parser.addPositionalArgument( QStringLiteral( "directory" ),
+				      QStringLiteral( "Where the .docset directory is created, the current one by default." ) );
+
+	const QCommandLineOption nameOption{ { QStringLiteral( "n" ), QStringLiteral( "name" ) },
+					     QStringLiteral( "Name of the docset." ),
+					     QStringLiteral( "name" ),
+					     QStringLiteral( "Synthetic" ) };
+	const QCommandLineOption schemaOption{ QStringLiteral( "schema" ),
+					       QStringLiteral( "Index layout, dash or zdash." ),
+					       QStringLiteral( "schema" ),
+					       QStringLiteral( "dash" ) };
+	const QCommandLineOption symbolsOption{ { QStringLiteral( "s" ), QStringLiteral( "symbols" ) },
+						QStringLiteral( "Number of symbols, k and M suffixes are accepted." ),
+						QStringLiteral( "count" ),
+						QStringLiteral( "10k" ) };
+	const QCommandLineOption seedOption{ QStringLiteral( "seed" ),
+					     QStringLiteral( "Seed of the random choices." ),
+					     QStringLiteral( "seed" ),
+					     QStringLiteral( "1" ) };
+	const QCommandLineOption anchorsOption{ QStringLiteral( "anchor-density" ),
+						QStringLiteral( "Share of symbols that point at an anchor, 0 to 1." ),
+						QStringLiteral( "share" ),
+						QStringLiteral( "0.9" ) };
+	const QCommandLineOption pageOption{ QStringLiteral( "symbols-per-page" ),
+					     QStringLiteral( "Symbols documented on one page." ),
+					     QStringLiteral( "count" ),
+					     QStringLiteral( "40" ) };
+	const QCommandLineOption indexOnlyOption{ QStringLiteral( "index-only" ),
+						  QStringLiteral( "Write the index but no pages." ) };
+
+	parser.addOptions(
+		{ nameOption, schemaOption, symbolsOption, seedOption, anchorsOption, pageOption, indexOnlyOption } );
+	parser.process( app );
+
+	QTextStream err{ stderr };
+	bool	    symbolsOk{ false }, seedOk{ false }, anchorsOk{ false }, pageOk{ false };
+
+	DocsetGenerator::Options options;
+	options.name	       = parser.value( nameOption );
+	options.symbolCount    = parseCount( parser.value( symbolsOption ), &symbolsOk );
+	options.seed	       = parser.value( seedOption ).toUInt( &seedOk );
+	options.anchorDensity  = parser.value( anchorsOption ).toDouble( &anchorsOk );
+	options.symbolsPerPage = parser.value( pageOption ).toInt( &pageOk );
+	options.writeDocuments = !parser.isSet( indexOnlyOption );
+
+	const QString schema{ parser.value( schemaOption ).toLower() };
+
+	if ( schema == QLatin1String( "zdash" ) ) { options.schema = DocsetGenerator::Schema::ZDash; }
+	else if ( schema != QLatin1String( "dash" ) )
+	{
+		err << "Unknown schema: " << schema << '\n';
+		return 1;
+	}
+
+	if ( !symbolsOk || options.symbolCount < 0 || !seedOk || !anchorsOk || !pageOk || options.symbolsPerPage < 1 )
+	{
+		err << "Invalid option value, see --help\n";
+		return 1;
+	}
+
+	const QStringList positional{ parser.positionalArguments() };
+	const QString	  directory{ positional.isEmpty() ? QStringLiteral( "." ) : positional.first() };
+
+	QElapsedTimer timer;
+	timer.start();
+
+	DocsetGenerator generator{ options };
+	const QString	path{ generator.generate( directory,
+						  [&err, &options]( qint64 written ) {
+							  err << '\r' << written << " / " << options.symbolCount << " symbols";
+							  err.flush();
+						  } ) };
+
+	err << '\n';
+
+	if ( path.isEmpty() )
+	{
+		err << "Failed: " << generator.errorString() << '\n';
+		return 1;
+	}
+
+	err << "Wrote " << path << " in " << timer.elapsed() / 1000.0 << " s\n";
+	return 0;
+}
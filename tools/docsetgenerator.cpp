@@ -0,0 +1,518 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "docsetgenerator.h"
+
+#include <util/sqlitedatabase.h>
+
+#include <sqlite3.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QUrl>
+#include <iterator>
+#include <random>
+
+namespace {
+const char* const Words[]{ "vector", "string",	 "map",	     "set",	 "list",   "queue",  "thread", "mutex",
+			   "future", "promise",	 "model",    "index",	 "view",   "item",   "widget", "layout",
+			   "event",  "signal",	 "slot",     "buffer",	 "reader", "writer", "stream", "parser",
+			   "token",  "cache",	 "pool",     "handle",	 "file",   "path",   "socket", "request",
+			   "reply",  "header",	 "value",    "key",	 "node",   "tree",   "graph",  "edge",
+			   "range",  "iterator", "allocator", "context", "config", "option", "state",  "error",
+			   "result", "size",	 "count",    "length",	 "begin",  "end",    "push",   "pop",
+			   "insert", "erase",	 "find",     "sort",	 "copy",   "move",   "swap",   "clear" };
+
+const char* const Namespaces[]{ "std", "Qt", "QtConcurrent", "KDevelop", "boost::asio", "detail", "internal" };
+
+// Types as Dash docsets spell them, with how often they occur in real ones
+const char* const Types[]{ "Method", "Function", "Class",  "Property", "Variable", "Constant",
+			   "Enum",   "Type",	 "Macro",  "Namespace", "Guide" };
+const double	  TypeWeights[]{ 34, 15, 12, 7, 7, 8, 5, 5, 3, 2, 2 };
+
+const qint64 ProgressInterval{ 100000 };
+const int    PagesPerSection{ 100 };
+const int    IndexPageLinks{ 1000 };
+
+/*!
+ * \brief Makes up symbol names with the shapes and lengths found in real docsets.
+ *
+ * Owns its random engine, so the names only depend on the seed and not on the
+ * other choices the generator makes.
+ */
+class NameGenerator
+{
+public:
+	explicit NameGenerator( quint32 seed )
+		: m_random{ seed }
+	{
+	}
+
+	QString next()
+	{
+		const int style{ std::uniform_int_distribution<int>( 0, 99 )( m_random ) };
+
+		if ( style < 40 )
+		{
+			// C++: Class, ns::Class, Class::member
+			QString name{ words( wordCount(), Case::Pascal ) };
+
+			if ( chance( 0.3 ) ) { name.prepend( QString::fromLatin1( pick( Namespaces ) ) + QLatin1String( "::" ) ); }
+			if ( chance( 0.6 ) ) { name += QLatin1String( "::" ) + words( wordCount(), Case::Camel ); }
+
+			return name;
+		}
+		if ( style < 60 )
+		{
+			// Java and JavaScript: package.Class.method
+			return words( 1, Case::Lower ) + QLatin1Char( '.' ) + words( wordCount(), Case::Pascal ) + QLatin1Char( '.' )
+			       + words( wordCount(), Case::Camel );
+		}
+		if ( style < 75 )
+		{
+			// Python: module.function_name
+			return words( 1, Case::Lower ) + QLatin1Char( '.' ) + words( wordCount(), Case::Snake );
+		}
+		if ( style < 85 )
+		{
+			// Free functions and the odd macro
+			return chance( 0.2 ) ? words( wordCount(), Case::Macro ) : words( wordCount(), Case::Camel );
+		}
+		if ( style < 95 )
+		{
+			// Go and shell style paths: net/http
+			return words( 1, Case::Lower ) + QLatin1Char( '/' ) + words( 1, Case::Lower );
+		}
+
+		// Guide titles
+		QString title{ words( 2 + wordCount(), Case::Sentence ) };
+		title[0] = title[0].toUpper();
+		return title;
+	}
+
+private:
+	enum class Case { Lower, Camel, Pascal, Snake, Macro, Sentence };
+
+	bool chance( double p ) { return std::bernoulli_distribution( p )( m_random ); }
+
+	template<typename T, std::size_t N>
+	T pick( const T ( &array )[N] )
+	{
+		return array[std::uniform_int_distribution<int>( 0, int( N ) - 1 )( m_random )];
+	}
+
+	// Most identifiers are one or two words, few are longer
+	int wordCount() { return 1 + m_wordCount( m_random ); }
+
+	QString words( int count, Case style )
+	{
+		QString result;
+
+		for ( int i = 0; i < count; ++i )
+		{
+			QString word{ QString::fromLatin1( pick( Words ) ) };
+
+			switch ( style )
+			{
+			case Case::Lower: break;
+			case Case::Camel:
+				if ( i > 0 ) { word[0] = word[0].toUpper(); }
+				break;
+			case Case::Pascal: word[0] = word[0].toUpper(); break;
+			case Case::Snake:
+				if ( i > 0 ) { word.prepend( QLatin1Char( '_' ) ); }
+				break;
+			case Case::Macro:
+				word = word.toUpper();
+				if ( i > 0 ) { word.prepend( QLatin1Char( '_' ) ); }
+				break;
+			case Case::Sentence:
+				if ( i > 0 ) { word.prepend( QLatin1Char( ' ' ) ); }
+				break;
+			}
+
+			result += word;
+		}
+
+		return result;
+	}
+
+	std::mt19937			m_random;
+	std::discrete_distribution<int> m_wordCount{ 45, 35, 15, 5 };
+};
+
+/*!
+ * \brief Collects the sections of one page and writes it once it is complete.
+ */
+class PageWriter
+{
+public:
+	explicit PageWriter( const QString& documentPath )
+		: m_documentPath{ documentPath }
+	{
+	}
+
+	void start( const QString& path )
+	{
+		m_path = path;
+		m_html = "<html><head><meta charset=\"utf-8\"><title>" + path.toUtf8() + "</title></head><body>\n";
+	}
+
+	void add( const QString& name, const QString& anchor, bool dashAnchor, const QString& text )
+	{
+		const QByteArray escapedName{ name.toHtmlEscaped().toUtf8() };
+		const QByteArray escapedAnchor{ anchor.toHtmlEscaped().toUtf8() };
+
+		if ( anchor.isEmpty() ) { m_html += "<h2>" + escapedName + "</h2>\n"; }
+		else if ( dashAnchor )
+		{
+			m_html += "<a name=\"" + escapedAnchor + "\" class=\"dashAnchor\"></a><h2>" + escapedName + "</h2>\n";
+		}
+		else
+		{
+			m_html += "<h2 id=\"" + escapedAnchor + "\">" + escapedName + "</h2>\n";
+		}
+
+		m_html += "<p>" + text.toUtf8() + "</p>\n";
+	}
+
+	bool finish()
+	{
+		if ( m_path.isEmpty() ) { return true; }
+
+		m_html += "</body></html>\n";
+
+		const QString fileName{ QDir( m_documentPath ).filePath( m_path ) };
+		QDir{}.mkpath( QFileInfo( fileName ).path() );
+
+		QFile file{ fileName };
+		const bool ok{ file.open( QIODevice::WriteOnly ) && file.write( m_html ) == m_html.size() };
+		m_path.clear();
+		return ok;
+	}
+
+private:
+	QString	   m_documentPath;
+	QString	   m_path;
+	QByteArray m_html;
+};
+
+/*!
+ * \brief Runs the current statement of \a db to completion.
+ *
+ * SQLiteDatabase::execute() and prepare() only compile a statement, and next()
+ * doesn't tell a finished statement from a failed one.
+ */
+bool step( Zeal::Util::SQLiteDatabase& db )
+{
+	while ( db.next() ) {}
+
+	return sqlite3_errcode( db.handle() ) == SQLITE_DONE;
+}
+
+bool run( Zeal::Util::SQLiteDatabase& db, const QString& sql ) { return db.execute( sql ) && step( db ); }
+
+QString pagePath( qint64 page )
+{
+	return QStringLiteral( "section%1/page%2.html" ).arg( page / PagesPerSection ).arg( page );
+}
+
+QString fillerText( std::mt19937& random )
+{
+	const int length{ std::uniform_int_distribution<int>( 8, 40 )( random ) };
+	QString	  text;
+
+	for ( int i = 0; i < length; ++i )
+	{
+		if ( i > 0 ) { text += QLatin1Char( ' ' ); }
+		text += QString::fromLatin1( Words[std::uniform_int_distribution<int>( 0, int( std::size( Words ) ) - 1 )( random )] );
+	}
+
+	text[0] = text[0].toUpper();
+	return text + QLatin1Char( '.' );
+}
+}    // namespace
+
+DocsetGenerator::DocsetGenerator( const Options& options )
+	: m_options{ options }
+{
+	m_options.symbolsPerPage = qMax( 1, m_options.symbolsPerPage );
+	m_options.anchorDensity	 = qBound( 0.0, m_options.anchorDensity, 1.0 );
+}
+
+QString DocsetGenerator::errorString() const { return m_errorString; }
+
+QStringList DocsetGenerator::symbolNames( int count, quint32 seed )
+{
+	NameGenerator names{ seed };
+	QStringList   result;
+	result.reserve( count );
+
+	for ( int i = 0; i < count; ++i ) { result << names.next(); }
+
+	return result;
+}
+
+bool DocsetGenerator::fail( const QString& error )
+{
+	m_errorString = error;
+	return false;
+}
+
+bool DocsetGenerator::writeMetadata( const QString& path )
+{
+	const QDir docset{ path };
+	QSaveFile  plist{ docset.filePath( QStringLiteral( "Contents/Info.plist" ) ) };
+
+	if ( !plist.open( QIODevice::WriteOnly ) ) { return fail( plist.errorString() ); }
+
+	const QByteArray name{ m_options.name.toHtmlEscaped().toUtf8() };
+
+	plist.write( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		     "<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" "
+		     "\"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n"
+		     "<plist version=\"1.0\">\n<dict>\n"
+		     "\t<key>CFBundleIdentifier</key>\n\t<string>"
+		     + name.toLower()
+		     + "</string>\n"
+		       "\t<key>CFBundleName</key>\n\t<string>"
+		     + name
+		     + "</string>\n"
+		       "\t<key>DocSetPlatformFamily</key>\n\t<string>"
+		     + name.toLower()
+		     + "</string>\n"
+		       "\t<key>dashIndexFilePath</key>\n\t<string>index.html</string>\n"
+		       "\t<key>isDashDocset</key>\n\t<true/>\n"
+		       "</dict>\n</plist>\n" );
+
+	if ( !plist.commit() ) { return fail( plist.errorString() ); }
+
+	QSaveFile meta{ docset.filePath( QStringLiteral( "meta.json" ) ) };
+
+	if ( !meta.open( QIODevice::WriteOnly ) ) { return fail( meta.errorString() ); }
+
+	const QJsonObject object{ { QStringLiteral( "name" ), m_options.name },
+				  { QStringLiteral( "title" ), m_options.name },
+				  { QStringLiteral( "version" ), QStringLiteral( "%1" ).arg( m_options.symbolCount ) },
+				  { QStringLiteral( "revision" ), QStringLiteral( "%1" ).arg( m_options.seed ) } };
+
+	meta.write( QJsonDocument( object ).toJson() );
+
+	return meta.commit() || fail( meta.errorString() );
+}
+
+QString DocsetGenerator::generate( const QString& directory, const std::function<void( qint64 written )>& progress )
+{
+	m_errorString.clear();
+
+	const QString path{ QDir( directory ).absoluteFilePath( m_options.name + QLatin1String( ".docset" ) ) };
+	const QString documentPath{ QDir( path ).filePath( QStringLiteral( "Contents/Resources/Documents" ) ) };
+	const QString indexPath{ QDir( path ).filePath( QStringLiteral( "Contents/Resources/docSet.dsidx" ) ) };
+
+	if ( !QDir{}.mkpath( documentPath ) )
+	{
+		fail( QStringLiteral( "Can't create %1" ).arg( documentPath ) );
+		return {};
+	}
+
+	if ( !writeMetadata( path ) ) { return {}; }
+
+	// Never append to the index of an earlier run
+	if ( QFile::exists( indexPath ) && !QFile::remove( indexPath ) )
+	{
+		fail( QStringLiteral( "Can't replace %1" ).arg( indexPath ) );
+		return {};
+	}
+
+	Zeal::Util::SQLiteDatabase db{ indexPath };
+	const bool		   dash{ m_options.schema == Schema::Dash };
+
+	const QStringList schema{ dash ? QStringList{ QStringLiteral(
+					       "CREATE TABLE searchIndex(id INTEGER PRIMARY KEY, name TEXT, type TEXT, path TEXT)" ) }
+				       : QStringList{ QStringLiteral( "CREATE TABLE ztokentype(z_pk INTEGER PRIMARY KEY, ztypename VARCHAR)" ),
+						      QStringLiteral( "CREATE TABLE zfilepath(z_pk INTEGER PRIMARY KEY, zpath VARCHAR)" ),
+						      QStringLiteral( "CREATE TABLE ztokenmetainformation(z_pk INTEGER PRIMARY KEY, "
+								      "ztoken INTEGER, zfile INTEGER, zanchor VARCHAR)" ),
+						      QStringLiteral( "CREATE TABLE ztoken(z_pk INTEGER PRIMARY KEY, ztokenname VARCHAR, "
+								      "ztokentype INTEGER, zmetainformation INTEGER)" ) } };
+
+	// A crash leaves a broken docset either way, so skip the journal
+	if ( !db.isOpen() || !run( db, QStringLiteral( "PRAGMA journal_mode=OFF" ) )
+	     || !run( db, QStringLiteral( "PRAGMA synchronous=OFF" ) ) || !run( db, QStringLiteral( "BEGIN" ) ) )
+	{
+		fail( db.lastError() );
+		return {};
+	}
+
+	for ( const QString& statement : schema )
+	{
+		if ( !run( db, statement ) )
+		{
+			fail( db.lastError() );
+			return {};
+		}
+	}
+
+	bool ok{ true };
+
+	if ( !dash )
+	{
+		for ( int i = 0; i < int( std::size( Types ) ); ++i )
+		{
+			db.prepare( QStringLiteral( "INSERT INTO ztokentype(z_pk, ztypename) VALUES (?1, ?2)" ) );
+			db.bindInt64( 1, i + 1 );
+			db.bindText( 2, QString::fromLatin1( Types[i] ) );
+			ok = step( db ) && ok;
+		}
+
+		if ( !ok )
+		{
+			fail( db.lastError() );
+			return {};
+		}
+	}
+
+	NameGenerator			names{ m_options.seed };
+	std::mt19937			random{ m_options.seed + 1 };
+	std::mt19937			text{ m_options.seed + 2 };    // Keeps the index the same with or without pages
+	std::discrete_distribution<int> type( std::begin( TypeWeights ), std::end( TypeWeights ) );
+	std::bernoulli_distribution	anchored{ m_options.anchorDensity };
+	PageWriter			pages{ documentPath };
+	qint64				currentPage{ -1 };
+
+	for ( qint64 i = 0; i < m_options.symbolCount; ++i )
+	{
+		const qint64 page{ i / m_options.symbolsPerPage };
+
+		if ( page != currentPage )
+		{
+			if ( m_options.writeDocuments && !pages.finish() )
+			{
+				fail( QStringLiteral( "Can't write %1" ).arg( pagePath( currentPage ) ) );
+				return {};
+			}
+
+			currentPage = page;
+
+			if ( m_options.writeDocuments ) { pages.start( pagePath( page ) ); }
+
+			if ( !dash )
+			{
+				db.prepare( QStringLiteral( "INSERT INTO zfilepath(z_pk, zpath) VALUES (?1, ?2)" ) );
+				db.bindInt64( 1, page + 1 );
+				db.bindText( 2, pagePath( page ) );
+				ok = step( db ) && ok;
+			}
+		}
+
+		const QString name{ names.next() };
+		const int     typeIndex{ type( random ) };
+		const QString typeName{ QString::fromLatin1( Types[typeIndex] ) };
+		QString	      anchor;
+
+		// Dash anchors follow Apple's scheme, ZDash ones are plain ids
+		if ( anchored( random ) )
+		{
+			anchor = dash ? QStringLiteral( "//apple_ref/cpp/%1/%2" )
+						.arg( typeName, QString::fromLatin1( QUrl::toPercentEncoding( name ) ) )
+				      : QStringLiteral( "sym-%1" ).arg( i );
+		}
+
+		if ( dash )
+		{
+			db.prepare( QStringLiteral( "INSERT INTO searchIndex(name, type, path) VALUES (?1, ?2, ?3)" ) );
+			db.bindText( 1, name );
+			db.bindText( 2, typeName );
+			db.bindText( 3, anchor.isEmpty() ? pagePath( page ) : pagePath( page ) + QLatin1Char( '#' ) + anchor );
+			ok = step( db ) && ok;
+		}
+		else
+		{
+			db.prepare( QStringLiteral(
+				"INSERT INTO ztokenmetainformation(z_pk, ztoken, zfile, zanchor) VALUES (?1, ?1, ?2, ?3)" ) );
+			db.bindInt64( 1, i + 1 );
+			db.bindInt64( 2, page + 1 );
+
+			if ( anchor.isEmpty() ) { db.bindNull( 3 ); }
+			else { db.bindText( 3, anchor ); }
+
+			ok = step( db ) && ok;
+
+			db.prepare( QStringLiteral(
+				"INSERT INTO ztoken(z_pk, ztokenname, ztokentype, zmetainformation) VALUES (?1, ?2, ?3, ?1)" ) );
+			db.bindInt64( 1, i + 1 );
+			db.bindText( 2, name );
+			db.bindInt64( 3, typeIndex + 1 );
+			ok = step( db ) && ok;
+		}
+
+		if ( !ok )
+		{
+			fail( db.lastError() );
+			return {};
+		}
+
+		if ( m_options.writeDocuments ) { pages.add( name, anchor, dash, fillerText( text ) ); }
+
+		if ( progress && ( i + 1 ) % ProgressInterval == 0 ) { progress( i + 1 ); }
+	}
+
+	if ( m_options.writeDocuments && !pages.finish() )
+	{
+		fail( QStringLiteral( "Can't write %1" ).arg( pagePath( currentPage ) ) );
+		return {};
+	}
+
+	if ( !run( db, QStringLiteral( "COMMIT" ) ) )
+	{
+		fail( db.lastError() );
+		return {};
+	}
+
+	// The home page links the first pages, like the overview of a real docset
+	QFile index{ QDir( documentPath ).filePath( QStringLiteral( "index.html" ) ) };
+
+	if ( !index.open( QIODevice::WriteOnly ) )
+	{
+		fail( index.errorString() );
+		return {};
+	}
+
+	index.write( "<html><head><meta charset=\"utf-8\"><title>" + m_options.name.toHtmlEscaped().toUtf8()
+		     + "</title></head><body>\n<p>A synthetic docset with "
+		     + QByteArray::number( m_options.symbolCount ) + " symbols.</p>\n<ul>\n" );
+
+	for ( qint64 page = 0; m_options.writeDocuments && page <= qMin<qint64>( currentPage, IndexPageLinks - 1 ); ++page )
+	{
+		index.write( "<li><a href=\"" + pagePath( page ).toUtf8() + "\">" + pagePath( page ).toUtf8() + "</a></li>\n" );
+	}
+
+	index.write( "</ul>\n</body></html>\n" );
+
+	if ( progress ) { progress( m_options.symbolCount ); }
+
+	return path;
+}
@@ -0,0 +1,95 @@
+/****************************************************************************
+ * * *
+ ** Copyright (C) 2024 Petross404
+ ** Contact: petross404@gmail.com
+ **
+ ** This file is part of KDevZealDoc.
+ **
+ ** KDevZealDoc is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** KDevZealDoc is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with KDevZealDoc. If not, see <https://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+/*!
+ * \class DocsetGenerator
+ * \brief Writes synthetic docsets of any size.
+ *
+ * A generated docset is a complete `.docset` directory: `Info.plist`, `meta.json`,
+ * a `Documents/` tree whose pages hold the anchors the index points at, and a
+ * `docSet.dsidx` in either the Dash or the ZDash schema.
+ *
+ * Symbol names are modeled on real docsets: C++, Java, Python and path style
+ * qualifiers, one to several words per component and a few guide titles with
+ * spaces. The same seed always gives the same docset, so measurements of different
+ * runs and machines are comparable. Symbols are streamed to disk, the memory use
+ * doesn't depend on their number.
+ */
+class DocsetGenerator
+{
+public:
+	/*!
+	 * \brief The layout of `docSet.dsidx`.
+	 */
+	enum class Schema {
+		Dash, /*!< A single `searchIndex` table. */
+		ZDash /*!< Apple's Core Data tables `ztoken`, `ztokenmetainformation`, `zfilepath` and `ztokentype`. */
+	};
+
+	/*!
+	 * \brief What to generate.
+	 */
+	struct Options
+	{
+		QString name{ QStringLiteral( "Synthetic" ) };	  /*!< Docset name, also its directory name. */
+		Schema	schema	       = Schema::Dash;		  /*!< Layout of the index. */
+		qint64	symbolCount    = 10000;			  /*!< Number of index entries. */
+		quint32 seed	       = 1;			  /*!< Seed of all random choices. */
+		double	anchorDensity  = 0.9;			  /*!< Share of symbols that point at an anchor. */
+		int	symbolsPerPage = 40;			  /*!< Symbols documented on one page. */
+		bool	writeDocuments = true;			  /*!< Write the pages, not only the index. */
+	};
+
+	explicit DocsetGenerator( const Options& options );
+
+	/*!
+	 * \brief Writes the docset below \a directory.
+	 *
+	 * \param progress Called with the number of symbols written so far, every
+	 *        100000 symbols and once at the end.
+	 * \return The path of the `.docset` directory, empty on error, see errorString().
+	 */
+	QString generate( const QString& directory, const std::function<void( qint64 written )>& progress = {} );
+
+	/*!
+	 * \brief Describes why the last generate() failed.
+	 */
+	[[nodiscard]] QString errorString() const;
+
+	/*!
+	 * \brief Returns the first \a count names a docset generated with \a seed holds.
+	 */
+	static QStringList symbolNames( int count, quint32 seed );
+
+private:
+	bool writeMetadata( const QString& path );
+	bool fail( const QString& error );
+
+	Options m_options;
+	QString m_errorString;
+};